@@ -0,0 +1,87 @@
+/**
+ * @file AnalogSampler.cpp
+ * @brief AnalogSampler クラスメンバの実装
+ */
+
+#include "AnalogSampler.h"
+
+
+AnalogSampler::AnalogSampler(const int *_pins, int _num, uint8_t _overShift){
+    num = (_num > SAMPLER_MAX_CH) ? SAMPLER_MAX_CH : ((_num < 0) ? 0 : _num);
+    overShift = (_overShift > 8) ? 8 : _overShift;
+
+    for(int i=0; i<num; i++){
+        pins[i] = _pins[i];
+    }
+    for(int i=0; i<SAMPLER_MAX_CH; i++){
+        sums[i] = 0;
+        values[i] = 0;
+    }
+
+    cursor = 0;
+    round = 0;
+    time = 0;
+    seq = 0;
+    ready = false;
+}
+
+void AnalogSampler::sample(){
+    while(num > 0 && !poll(num)){
+    }
+}
+
+int AnalogSampler::poll(int maxRead){
+    if(num == 0) return 0;
+
+    for(int i=0; i<maxRead; i++){
+        sums[cursor] += analogRead(pins[cursor]);
+
+        if(++cursor < num) continue;
+
+        cursor = 0;
+        if(++round < (1U << overShift)) continue;
+
+        round = 0;
+        publish();
+        return 1;   // 次の組はこの次の呼び出しから
+    }
+
+    return 0;
+}
+
+bool AnalogSampler::read(snapshot *out){
+    uint8_t before, after;
+
+    if(!ready) return false;
+
+    do{
+        before = seq;
+        for(int i=0; i<num; i++){
+            out->value[i] = values[i];
+        }
+        out->time = time;
+        after = seq;
+    }while((before & 0x01) || before != after);     // 公開中に読んだらやり直す
+
+    out->num = num;
+    out->seq = after >> 1;
+
+    return true;
+}
+
+uint16_t AnalogSampler::get(int ch){
+    if(ch < 0 || ch >= num) return 0;
+
+    return values[ch];
+}
+
+void AnalogSampler::publish(){
+    seq++;
+    for(int i=0; i<num; i++){
+        values[i] = (uint16_t)(sums[i] >> overShift);
+        sums[i] = 0;
+    }
+    time = micros();
+    ready = true;
+    seq++;
+}
\ No newline at end of file
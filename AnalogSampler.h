@@ -0,0 +1,147 @@
+/**
+ * @file AnalogSampler.h
+ * @brief 複数のアナログ入力をまとめて取り込み，オーバーサンプリングする
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef ANALOG_SAMPLER_H
+#define ANALOG_SAMPLER_H
+
+#include <Arduino.h>
+
+#define SAMPLER_MAX_CH 8        /**< 取り込めるアナログ入力の最大数 */
+
+
+/**
+ * @brief アナログ入力の取り込みクラス
+ *
+ *
+ * 指定したアナログ入力を順番に取り込み， 2^overShift 回ずつ足し合わせて平均(間引き)した値を
+ * 取り込み完了時刻とともに1組の値として公開する @n
+ * 各入力を交互に取り込むので，1組の値の中で取り込み時刻がそろう
+ *
+ * sample() は1組をまとめて取り込む @n
+ * poll() は1回の呼び出しで指定した数だけ取り込み，1組がそろうと公開する @n
+ * 周期ごとのAD変換待ちを分散できる
+ *
+ * read() は公開中の値の組を壊れていない状態で写す @n
+ * poll() をタイマ割り込みで呼び出しても loop() から安全に読める
+ *
+ * 例)
+ * @code
+ *  const int pins[] = {A0, A1, A2};
+ *  AnalogSampler Sampler(pins, 3, 2);      // 4回ずつ平均
+ *
+ *  void loop(){
+ *      AnalogSampler::snapshot in;
+ *
+ *      Sampler.poll(3);        // 1周期に3回だけ取り込む
+ *      Sampler.read(&in);
+ *      ...
+ *  }
+ * @endcode
+ *
+ * @note    値の大きさは analogRead() と同じである
+ * @note    Arduino のAPIではAD変換の完了を待たずに取り込めないため，1回の取り込みは analogRead() 1回である
+ */
+class AnalogSampler
+{
+public:
+
+    /**
+     * 取り込んだ値の組
+     */
+    struct snapshot{
+        uint16_t value[SAMPLER_MAX_CH];     /**< 入力の値 指定した順 */
+        unsigned long time;                 /**< 取り込み完了時刻 micros() [us] */
+        uint8_t num;                        /**< 入力の数 */
+        uint8_t seq;                        /**< 公開した回数 新しい組かどうかの判定に使う */
+    };
+
+    /**
+     * コンストラクタ
+     *
+     * @param _pins         取り込むアナログ入力のピン番号の配列
+     * @param _num          入力の数 @p 1 ~ @p SAMPLER_MAX_CH  超えた分は取り込まない
+     * @param _overShift    1つの値を作る取り込み回数 2^_overShift @p 0 ~ @p 8
+     */
+    AnalogSampler(const int *_pins, int _num, uint8_t _overShift = 0);
+
+    /**
+     * 1組の値をまとめて取り込み，公開する
+     *
+     * @note    入力の数 × 2^overShift 回 analogRead() を実行する
+     */
+    void sample();
+
+    /**
+     * 指定した回数だけ取り込む @n
+     * 1組がそろったら公開する
+     *
+     * @param maxRead   この呼び出しでの最大の取り込み回数
+     *
+     * @retval 1    この呼び出しで公開した
+     * @retval 0    まだそろっていない
+     */
+    int poll(int maxRead = 1);
+
+    /**
+     * 公開中の値の組を写す
+     *
+     * @param out   写し先
+     *
+     * @retval true     一度でも公開された
+     * @retval false    まだ公開されていない out は変更しない
+     */
+    bool read(snapshot *out);
+
+    /**
+     * 公開中の値を1つ取得する
+     *
+     * @param ch    入力の番号 コンストラクタで指定した順 @p 0 ~
+     *
+     * @return  入力の値 番号が不正なら @p 0
+     */
+    uint16_t get(int ch);
+
+private:
+
+    /**
+     * 取り込み中の組を公開する
+     */
+    void publish();
+
+    int pins[SAMPLER_MAX_CH];
+    uint8_t num;
+    uint8_t overShift;
+
+    /**
+     * 取り込み中の合計
+     */
+    unsigned long sums[SAMPLER_MAX_CH];
+
+    /**
+     * 次に取り込む入力の番号と，何周目か
+     */
+    uint8_t cursor;
+    uint16_t round;
+
+    /**
+     * 公開中の値の組
+     */
+    volatile uint16_t values[SAMPLER_MAX_CH];
+    volatile unsigned long time;
+
+    /**
+     * 公開の書き込み中は奇数になる
+     */
+    volatile uint8_t seq;
+
+    /**
+     * 一度でも公開したか
+     */
+    volatile bool ready;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+/**
+ * @file AxisShaper.cpp
+ * @brief AxisShaper クラスメンバの実装
+ */
+
+#include "AxisShaper.h"
+
+
+AxisShaper::AxisShaper(int _maxOut, int _range){
+    maxOut = _maxOut;
+    range = (_range > 0) ? _range : 1;
+    center = _range;
+    deadband = 0;
+    rateLimit = 0;
+    output = 0;
+
+    setExpo(0);
+}
+
+void AxisShaper::setCenter(int raw){
+    center = raw;
+}
+
+void AxisShaper::setDeadband(int band){
+    deadband = constrain(band, 0, range - 1);
+}
+
+void AxisShaper::setExpo(int expo){
+    expo = constrain(expo, 0, 100);
+
+    for(int i=0; i<SHAPER_LUT_SIZE; i++){
+        long x = (long)i * SHAPER_ONE / (SHAPER_LUT_SIZE - 1);
+        long x3 = x * x / SHAPER_ONE * x / SHAPER_ONE;
+
+        lut[i] = (int16_t)(((100 - expo) * x + expo * x3) / 100);
+    }
+}
+
+void AxisShaper::setMaxOut(int _maxOut){
+    maxOut = _maxOut;
+}
+
+void AxisShaper::setRateLimit(int maxStep){
+    rateLimit = (maxStep > 0) ? maxStep : 0;
+}
+
+int AxisShaper::update(int raw){
+    int diff = raw - center;
+    long mag = (diff < 0) ? -diff : diff;
+    long target = 0;
+
+    if(mag > deadband){
+        const int step = SHAPER_ONE / (SHAPER_LUT_SIZE - 1);
+        long x = (mag - deadband) * SHAPER_ONE / (range - deadband);
+        long y;
+        int index;
+
+        if(x > SHAPER_ONE) x = SHAPER_ONE;
+
+        index = x / step;
+        if(index >= SHAPER_LUT_SIZE - 1){
+            y = lut[SHAPER_LUT_SIZE - 1];
+        }
+        else{
+            y = lut[index] + (lut[index + 1] - lut[index]) * (x % step) / step;
+        }
+
+        target = y * maxOut / SHAPER_ONE;
+        if(diff < 0) target = -target;
+    }
+
+    if(rateLimit > 0){
+        target = constrain(target, (long)output - rateLimit, (long)output + rateLimit);
+    }
+
+    output = (int)target;
+
+    return output;
+}
+
+int AxisShaper::get(){
+    return output;
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+/**
+ * @file AxisShaper.h
+ * @brief ジョイスティックなどの入力を移動速度に変換する整形処理
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef AXIS_SHAPER_H
+#define AXIS_SHAPER_H
+
+#include <Arduino.h>
+
+#define SHAPER_LUT_SIZE 17      /**< 入力特性の表の大きさ 16区間 */
+#define SHAPER_ONE 4096         /**< 正規化した入力・出力の 1.0 に相当する値 */
+
+
+/**
+ * @brief 1軸の入力整形クラス
+ *
+ *
+ * アナログ入力の生の値を，次の順に処理して整数の出力にする
+ *  -# 中心値を引く (中心の校正)
+ *  -# 不感帯を除いて正規化する
+ *  -# 指数カーブ(表引き)で中心付近を細かくする
+ *  -# 最大値に拡大する
+ *  -# 1回あたりの変化量を制限する
+ *
+ * 計算はすべて整数で行うので， UnderBody::moveXY(int, int, int) にそのまま渡せる
+ *
+ * 例)
+ * @code
+ *  AxisShaper ShapeX(500);     // 最大 500[mm/s]
+ *
+ *  void setup(){
+ *      ShapeX.setCenter(analogRead(A0));
+ *      ShapeX.setDeadband(40);
+ *      ShapeX.setExpo(30);
+ *      ShapeX.setRateLimit(20);    // 1周期あたり 20[mm/s] まで
+ *  }
+ *
+ *  void loop(){
+ *      Omni4.moveXY(ShapeX.update(analogRead(A0)), 0, 0);
+ *  }
+ * @endcode
+ */
+class AxisShaper
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _maxOut   出力の最大値 出力は @p -_maxOut ~ @p _maxOut
+     * @param _range    中心から端までの入力の幅 12bitのADなら @p 2048
+     */
+    AxisShaper(int _maxOut, int _range = 2048);
+
+    /**
+     * 中心値を設定する 入力がこの値のとき出力が 0 になる
+     *
+     * @param raw   中心での入力の値
+     */
+    void setCenter(int raw);
+
+    /**
+     * 不感帯を設定する
+     *
+     * @param band  中心からこの幅以内の入力を 0 とみなす
+     */
+    void setDeadband(int band);
+
+    /**
+     * 指数カーブの強さを設定する
+     *
+     * 出力 = (1 - expo) * 入力 + expo * 入力^3 (入力，出力は -1.0 ~ 1.0)
+     *
+     * @param expo  強さ @p 0 ~ @p 100 [%] @p 0 で直線
+     */
+    void setExpo(int expo);
+
+    /**
+     * 出力の最大値を設定する
+     *
+     * @param _maxOut   出力の最大値
+     */
+    void setMaxOut(int _maxOut);
+
+    /**
+     * 1回の update() での出力の変化量の上限を設定する
+     *
+     * @param maxStep   変化量の上限 @p 0 なら制限しない
+     */
+    void setRateLimit(int maxStep);
+
+    /**
+     * 入力を整形する
+     *
+     * @param raw   入力の生の値
+     *
+     * @return  出力 @p -maxOut ~ @p maxOut
+     */
+    int update(int raw);
+
+    /**
+     * @return 最後の update() の出力
+     */
+    int get();
+
+private:
+
+    int maxOut;
+    int range;
+    int center;
+    int deadband;
+    int rateLimit;
+
+    /**
+     * 現在の出力
+     */
+    int output;
+
+    /**
+     * 入力特性の表 入力 0 ~ SHAPER_ONE に対する出力 0 ~ SHAPER_ONE
+     */
+    int16_t lut[SHAPER_LUT_SIZE];
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,239 @@
+/**
+ * @file BusRecorder.cpp
+ * @brief BusRecorder , BusReplayer , ReplayFets クラスメンバの実装
+ */
+
+#include "BusRecorder.h"
+#include "InterruptLock.h"
+
+
+BusRecorder::BusRecorder(){
+    clear();
+}
+
+void BusRecorder::clear(){
+    unsigned long state = lockInterrupts();
+
+    head = 0;
+    tail = 0;
+    used = 0;
+    lastHeader = 0;
+    lastType = 0;
+    lastTime = micros();
+    dropped = 0;
+
+    unlockInterrupts(state);
+}
+
+void BusRecorder::record(uint8_t type, const uint8_t *frame, int len){
+    if(len < 1 || len > REC_MAX_LEN) return;
+
+    unsigned long state = lockInterrupts();     // 割り込みから送信されても記録が混ざらないようにする
+
+    writeHeader(type, len, micros());
+    for(int i=0; i<len; i++){
+        writeByte(frame[i]);
+    }
+
+    unlockInterrupts(state);
+}
+
+void BusRecorder::recordRx(uint8_t data){
+    unsigned long state = lockInterrupts();
+    unsigned long now = micros();
+
+    if(lastType == REC_RX
+    && (buff[lastHeader] & 0x0F) < REC_MAX_LEN
+    && now - lastTime <= REC_MERGE_TIME
+    && !(used >= RECORDER_SIZE && tail == lastHeader)){    // 続けて受信したデータは前の記録に追加する
+        writeByte(data);
+        buff[lastHeader]++;
+    }
+    else{
+        writeHeader(REC_RX, 1, now);
+        writeByte(data);
+    }
+
+    unlockInterrupts(state);
+}
+
+int BusRecorder::dump(Print *out){
+    uint16_t index = tail;
+
+    for(uint16_t i=0; i<used; i++){
+        out->write(buff[index]);
+        index = (index + 1) % RECORDER_SIZE;
+    }
+
+    return used;
+}
+
+int BusRecorder::getSize(){
+    return used;
+}
+
+unsigned int BusRecorder::getDropped(){
+    return dropped;
+}
+
+void BusRecorder::writeHeader(uint8_t type, int len, unsigned long time){
+    unsigned long dt = time - lastTime;
+
+    writeByte((uint8_t)((type << 4) | (len & 0x0F)));
+    lastHeader = (head + RECORDER_SIZE - 1) % RECORDER_SIZE;
+    lastType = type;
+    lastTime = time;
+
+    while(dt >= 0x80){
+        writeByte((uint8_t)(0x80 | (dt & 0x7F)));
+        dt >>= 7;
+    }
+    writeByte((uint8_t)dt);
+}
+
+void BusRecorder::writeByte(uint8_t data){
+    if(used >= RECORDER_SIZE) dropOldest();
+
+    buff[head] = data;
+    head = (head + 1) % RECORDER_SIZE;
+    used++;
+}
+
+void BusRecorder::dropOldest(){
+    uint16_t size = 1 + (buff[tail] & 0x0F);
+    uint16_t index = (tail + 1) % RECORDER_SIZE;
+
+    if(tail == lastHeader) lastType = 0;    // 書き込み中の記録は追加できなくする
+
+    while(size < used && (buff[index] & 0x80)){     // 時刻の長さ
+        index = (index + 1) % RECORDER_SIZE;
+        size++;
+    }
+    size++;
+
+    if(size > used) size = used;
+
+    tail = (tail + size) % RECORDER_SIZE;
+    used -= size;
+    dropped++;
+}
+
+
+
+BusReplayer::BusReplayer(const uint8_t *_log, int _len){
+    log = _log;
+    len = _len;
+    rewind();
+}
+
+void BusReplayer::rewind(){
+    pos = 0;
+    recTime = 0;
+    nowTime = 0;
+    rxPos = 0;
+    rxLeft = 0;
+}
+
+int BusReplayer::next(uint8_t *type, unsigned long *time, uint8_t *data){
+    unsigned long dt;
+    int dataPos;
+    int dataLen = parse(pos, type, &dt, &dataPos);
+
+    if(dataLen < 0) return -1;
+
+    for(int i=0; i<dataLen; i++){
+        data[i] = log[dataPos + i];
+    }
+
+    recTime += (pos == 0) ? 0 : dt;    // 先頭の記録を時刻0とする
+    *time = recTime;
+    pos = dataPos + dataLen;
+
+    return dataLen;
+}
+
+void BusReplayer::setTime(unsigned long time){
+    nowTime = time;
+}
+
+int BusReplayer::readRx(){
+    while(rxLeft <= 0){
+        uint8_t type;
+        unsigned long dt;
+        int dataPos;
+        int dataLen = parse(pos, &type, &dt, &dataPos);
+
+        if(dataLen < 0) return -1;
+        if(pos != 0 && recTime + dt > nowTime) return -1;   // まだ受信していない
+
+        recTime += (pos == 0) ? 0 : dt;
+        pos = dataPos + dataLen;
+
+        if(type == REC_RX){
+            rxPos = dataPos;
+            rxLeft = dataLen;
+        }
+    }
+
+    rxLeft--;
+    return log[rxPos++];
+}
+
+unsigned long BusReplayer::getEndTime(){
+    unsigned long time = 0;
+    int at = 0;
+    uint8_t type;
+    unsigned long dt;
+    int dataPos;
+    int dataLen;
+
+    while((dataLen = parse(at, &type, &dt, &dataPos)) >= 0){
+        if(at != 0) time += dt;
+        at = dataPos + dataLen;
+    }
+
+    return time;
+}
+
+int BusReplayer::parse(int at, uint8_t *type, unsigned long *dt, int *dataPos){
+    int dataLen;
+    int shift = 0;
+
+    if(at >= len) return -1;
+
+    *type = log[at] >> 4;
+    dataLen = log[at] & 0x0F;
+    at++;
+
+    *dt = 0;
+    while(at < len && shift < 32){
+        *dt |= (unsigned long)(log[at] & 0x7F) << shift;
+        shift += 7;
+        if(!(log[at++] & 0x80)) break;
+    }
+
+    if(at + dataLen > len) return -1;
+
+    *dataPos = at;
+    return dataLen;
+}
+
+
+
+ReplayFets::ReplayFets(BusReplayer *_replayer, char _id, Fets::portNum outputPort, Fets::portNum inputPort) : Fets(_id, outputPort, inputPort){
+    replayer = _replayer;
+    sent = 0;
+}
+
+unsigned long ReplayFets::getSent(){
+    return sent;
+}
+
+void ReplayFets::send(char data){
+    (void)data;
+    sent++;
+}
+
+int ReplayFets::recieve(){
+    return replayer->readRx();
+}
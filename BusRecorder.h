@@ -0,0 +1,318 @@
+/**
+ * @file BusRecorder.h
+ * @brief モジュールとの通信を記録し，再生する
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/18
+ */
+
+#ifndef BUS_RECORDER_H
+#define BUS_RECORDER_H
+
+#include <Arduino.h>
+
+#include "Fets.h"
+
+#define RECORDER_SIZE 512       /**< 記録に使うRAMの大きさ[byte] */
+#define REC_MAX_LEN 15          /**< 1つの記録に入るデータの最大長[byte] */
+#define REC_MERGE_TIME 1000     /**< この時間[us]以内に続けて受信したデータは1つの記録にまとめる */
+
+#define REC_FET_TX 0x01         /**< 記録の種類 Fets の送信フレーム */
+#define REC_UB_TX 0x02          /**< 記録の種類 UnderBody の送信フレーム */
+#define REC_RX 0x03             /**< 記録の種類 受信データ */
+
+
+/**
+ * @brief 通信の記録
+ *
+ *
+ * Fets , UnderBody が送信したフレームと受信したデータを時刻つきでRAMのリングバッファに記録する @n
+ * 満杯になると古い記録から捨てる
+ *
+ * 記録の形式は次の通りで，1記録あたり 2byte + データ長 程度である
+ *  - 1byte目 : 上位4bitが種類 REC_FET_TX , REC_UB_TX , REC_RX ，下位4bitがデータ長
+ *  - 時刻 : 前の記録からの経過時間[us] 下位から7bitずつ，最上位bitが1なら続きがある
+ *  - データ
+ *
+ * dump() でシリアル通信に書き出し，ホスト側でファイルに保存する @n
+ * 保存した記録は BusReplayer で再生できる
+ *
+ * 例)
+ * @code
+ *  S_Fets Module_S(&Serial1);
+ *  S_UnderBody Omni4(&Serial1);
+ *  BusRecorder Recorder;
+ *
+ *  void setup(){
+ *      Module_S.attachRecorder(&Recorder);
+ *      Omni4.attachRecorder(&Recorder);
+ *  }
+ *
+ *  void loop(){
+ *      ...
+ *      if(Serial.read() == 'd') Recorder.dump(&Serial);
+ *  }
+ * @endcode
+ *
+ * @note    record() , recordRx() , clear() は割り込みを禁止して記録を書き換えるので，
+ *          FrameQueue を使って割り込みから送信する Fets , UnderBody にも設定できる @n
+ *          割り込み禁止の前の状態は保存して戻す (InterruptLock.h)
+ */
+class BusRecorder
+{
+public:
+
+    /**
+     * コンストラクタ
+     */
+    BusRecorder();
+
+    /**
+     * 記録をすべて消去する
+     */
+    void clear();
+
+    /**
+     * 送信したフレームを記録する
+     *
+     * @param type      記録の種類 REC_FET_TX , REC_UB_TX
+     * @param frame     フレーム
+     * @param len       フレームの長さ @p 1 ~ @p REC_MAX_LEN
+     */
+    void record(uint8_t type, const uint8_t *frame, int len);
+
+    /**
+     * 受信したデータを記録する @n
+     * REC_MERGE_TIME 以内に続けて受信したデータは1つの記録にまとめる
+     *
+     * @param data      受信したデータ
+     */
+    void recordRx(uint8_t data);
+
+    /**
+     * 記録を古い順に書き出す
+     *
+     * @param out       書き出し先 &Serial など
+     *
+     * @return  書き出した大きさ[byte]
+     *
+     * @attention 書き出しは割り込みを禁止せずに行う 書き出し中に割り込みから記録すると，
+     *            書き出した記録の途中が新しい記録に置き換わることがあるので，書き出す間は記録を止める
+     */
+    int dump(Print *out);
+
+    /**
+     * @return 記録の大きさ[byte]
+     */
+    int getSize();
+
+    /**
+     * @return 満杯で捨てた記録の数
+     */
+    unsigned int getDropped();
+
+private:
+
+    /**
+     * 記録を書き始める
+     *
+     * @param type      記録の種類
+     * @param len       データ長
+     * @param time      時刻[us]
+     */
+    void writeHeader(uint8_t type, int len, unsigned long time);
+
+    /**
+     * 1byte書き込む 満杯なら古い記録を捨てる
+     */
+    void writeByte(uint8_t data);
+
+    /**
+     * 最も古い記録を捨てる
+     */
+    void dropOldest();
+
+    uint8_t buff[RECORDER_SIZE];
+
+    /**
+     * 次に書き込む位置
+     */
+    uint16_t head;
+
+    /**
+     * 最も古い記録の位置
+     */
+    uint16_t tail;
+
+    /**
+     * 記録の大きさ[byte]
+     */
+    uint16_t used;
+
+    /**
+     * 最新の記録の1byte目の位置
+     */
+    uint16_t lastHeader;
+
+    /**
+     * 最新の記録の種類 記録がなければ @p 0
+     */
+    uint8_t lastType;
+
+    /**
+     * 最新の記録の時刻[us]
+     */
+    unsigned long lastTime;
+
+    unsigned int dropped;
+};
+
+
+/**
+ * @brief 通信の記録の再生
+ *
+ *
+ * BusRecorder::dump() で書き出した記録を読み出す @n
+ * setTime() で再生時刻を進めると，その時刻までに受信したデータを readRx() で返す @n
+ * ReplayFets と組み合わせると，記録した受信データを同じ順番，同じ時刻で Fets に与えられる @n
+ * 送信フレームの比較や UnderBody の再生には ReplayTransport (ReplayTransport.h) を使う
+ *
+ * 例) 記録した受信データを Fets に与える
+ * @code
+ *  BusReplayer Replayer(log, logSize);
+ *  ReplayFets Module_R(&Replayer);
+ *
+ *  for(unsigned long t = 0; t <= Replayer.getEndTime(); t += 10000){
+ *      Replayer.setTime(t);
+ *      Module_R.recvData();
+ *      ...
+ *  }
+ * @endcode
+ *
+ * @note    時刻は記録の先頭を @p 0 とした経過時間[us]である
+ */
+class BusReplayer
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _log      記録
+     * @param _len      記録の大きさ[byte]
+     */
+    BusReplayer(const uint8_t *_log, int _len);
+
+    /**
+     * 先頭に戻す
+     */
+    void rewind();
+
+    /**
+     * 次の記録を読み出す @n
+     * 再生時刻に関係なく読み出す
+     *
+     * @param type      記録の種類の格納先
+     * @param time      記録の時刻[us]の格納先
+     * @param data      データの格納先 @p REC_MAX_LEN byte以上
+     *
+     * @retval -1           記録の終わり，または記録が壊れている
+     * @retval 0~REC_MAX_LEN データ長
+     */
+    int next(uint8_t *type, unsigned long *time, uint8_t *data);
+
+    /**
+     * 再生時刻を設定する
+     *
+     * @param time      再生時刻[us]
+     */
+    void setTime(unsigned long time);
+
+    /**
+     * 再生時刻までに受信したデータを1byte返す @n
+     * 送信フレームの記録は読み飛ばす
+     *
+     * @retval -1       再生時刻までのデータがない
+     * @retval 0~0xFF   受信したデータ
+     */
+    int readRx();
+
+    /**
+     * @return 最後の記録の時刻[us]
+     */
+    unsigned long getEndTime();
+
+private:
+
+    /**
+     * at の位置から記録を読む
+     *
+     * @return データ長 読めなければ @p -1
+     */
+    int parse(int at, uint8_t *type, unsigned long *dt, int *dataPos);
+
+    const uint8_t *log;
+    int len;
+
+    /**
+     * 次に読む記録の位置
+     */
+    int pos;
+
+    /**
+     * 前に読んだ記録の時刻[us]
+     */
+    unsigned long recTime;
+
+    /**
+     * 再生時刻[us]
+     */
+    unsigned long nowTime;
+
+    /**
+     * readRx() で読んでいる受信データの位置と残り
+     */
+    int rxPos;
+    int rxLeft;
+};
+
+
+/**
+ * @brief 記録の再生用の Fets
+ *
+ *
+ * 受信データを BusReplayer から読み出す Fets の拡張クラス @n
+ * 送信したフレームは数えるだけで捨てる
+ */
+class ReplayFets : public Fets
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _replayer     受信データを読み出す BusReplayer
+     * @param _id           モジュールのID
+     * @param outputPort    使用する出力ポートの番号
+     * @param inputPort     使用する入力ポートの番号
+     */
+    ReplayFets(BusReplayer *_replayer, char _id = DEF_ID, Fets::portNum outputPort = Fets::None, Fets::portNum inputPort = Fets::None);
+
+    /**
+     * @return 送信したデータの数[byte]
+     */
+    unsigned long getSent();
+
+protected:
+
+    void send(char data); //override
+
+    int recieve(); //override
+
+private:
+
+    BusReplayer *replayer;
+
+    unsigned long sent;
+};
+
+#endif
\ No newline at end of file
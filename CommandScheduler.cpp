@@ -0,0 +1,199 @@
+/**
+ * @file CommandScheduler.cpp
+ * @brief CommandScheduler クラスメンバの実装
+ */
+
+#include "CommandScheduler.h"
+#include "Fets.h"
+
+
+CommandScheduler::CommandScheduler(Transport *_link, unsigned long baudrate, unsigned int period) : Transport(){
+    link = _link;
+    entryNum = 0;
+
+    setBudget((int)(baudrate / 10 * period / 1000));   // 1byte = スタート1bit + データ8bit + ストップ1bit
+    setPolicy(SCHED_PRIO_NORMAL);
+    clearStats();
+}
+
+void CommandScheduler::setBudget(int bytes){
+    budget = (bytes < FRAME_MAX_LEN) ? FRAME_MAX_LEN : bytes;
+}
+
+int CommandScheduler::getBudget(){
+    return budget;
+}
+
+void CommandScheduler::setPolicy(uint8_t priority, unsigned int deadline, bool coalesce){
+    policyPriority = (priority < SCHED_PRIO_NUM) ? priority : SCHED_PRIO_LOW;
+    policyDeadline = deadline;
+    policyCoalesce = coalesce;
+}
+
+int CommandScheduler::post(const uint8_t *frame, int len, uint8_t priority, unsigned int deadline, bool coalesce){
+    entry *e = NULL;
+    uint16_t key = 0;
+    int ret = 0;
+
+    if(len < 1 || len > FRAME_MAX_LEN) return -1;
+    if(priority >= SCHED_PRIO_NUM) priority = SCHED_PRIO_LOW;
+
+    coalesce = coalesce && coalesceKey(frame, len, &key);
+
+    if(coalesce){
+        for(int i=0; i<entryNum; i++){
+            if(entries[i].coalesce && entries[i].key == key){
+                e = &entries[i];
+                if(e->priority < priority) priority = e->priority;   // 上書きで優先度は下げない
+                stat.coalesced++;
+                ret = 1;
+                break;
+            }
+        }
+    }
+
+    if(e == NULL){
+        if(entryNum >= SCHED_QUEUE_SIZE){
+            int victim = -1;
+
+            for(int i=0; i<entryNum; i++){      // 最も優先度が低く，新しいものを捨てる
+                if(entries[i].priority > priority && (victim < 0 || entries[i].priority >= entries[victim].priority)){
+                    victim = i;
+                }
+            }
+
+            stat.dropped++;
+            if(victim < 0){
+                stat.rejected++;
+                return -2;
+            }
+
+            stat.evicted++;
+            entries[victim].len = 0;
+            compact();
+        }
+
+        e = &entries[entryNum++];
+        e->deferred = false;
+    }
+
+    for(int i=0; i<len; i++){
+        e->frame[i] = frame[i];
+    }
+    e->len = (uint8_t)len;
+    e->priority = priority;
+    e->coalesce = coalesce;
+    e->key = key;
+    e->deadline = 0;
+    if(deadline > 0){
+        e->deadline = millis() + deadline;
+        if(e->deadline == 0) e->deadline = 1;
+    }
+
+    return ret;
+}
+
+bool CommandScheduler::sendFrame(const uint8_t *frame, int len){
+    return post(frame, len, policyPriority, policyDeadline, policyCoalesce) >= 0;
+}
+
+int CommandScheduler::readByte(){
+    return link->readByte();
+}
+
+int CommandScheduler::run(){
+    unsigned long now = millis();
+    int remain = budget;
+
+    for(int p=0; p<SCHED_PRIO_NUM; p++){
+        for(int i=0; i<entryNum; i++){
+            entry *e = &entries[i];
+
+            if(e->len == 0 || e->priority != p) continue;
+
+            if(e->deadline != 0 && (long)(now - e->deadline) > 0){
+                e->len = 0;
+                stat.dropped++;
+                stat.expired++;
+                continue;
+            }
+
+            if(e->len > remain) break;      // 同じ優先度の中では順番を変えない
+
+            link->sendFrame(e->frame, e->len);
+            remain -= e->len;
+            e->len = 0;
+            stat.sent++;
+        }
+    }
+
+    compact();
+
+    for(int i=0; i<entryNum; i++){
+        if(!entries[i].deferred){
+            entries[i].deferred = true;
+            stat.deferred++;
+        }
+    }
+
+    stat.lastBytes = budget - remain;
+
+    return stat.lastBytes;
+}
+
+int CommandScheduler::count(){
+    return entryNum;
+}
+
+const CommandScheduler::stats &CommandScheduler::getStats(){
+    return stat;
+}
+
+void CommandScheduler::clearStats(){
+    stat.sent = 0;
+    stat.deferred = 0;
+    stat.coalesced = 0;
+    stat.dropped = 0;
+    stat.expired = 0;
+    stat.evicted = 0;
+    stat.rejected = 0;
+    stat.lastBytes = 0;
+}
+
+bool CommandScheduler::coalesceKey(const uint8_t *frame, int len, uint16_t *key){
+    uint8_t funcBit;
+
+    switch(len){
+    case 4:
+        funcBit = (frame[0] >> 3) & 0x0F;
+        *key = ((uint16_t)frame[3] << 8) | (frame[0] & 0x07);
+        break;
+
+    case 6:
+        funcBit = frame[1];
+        *key = ((uint16_t)frame[5] << 8) | (frame[0] & 0x07);
+        break;
+
+    case 8:
+        *key = 0xFFFF;      // 足回りモジュールは最後の命令だけが意味を持つ
+        return true;
+
+    default:
+        return false;
+    }
+
+    return funcBit >= FUNC_DIGITAL_OUT && funcBit <= FUNC_WAVE_SAWINV;
+}
+
+void CommandScheduler::compact(){
+    int num = 0;
+
+    for(int i=0; i<entryNum; i++){
+        if(entries[i].len == 0) continue;
+
+        if(num != i) entries[num] = entries[i];
+        num++;
+    }
+
+    entryNum = num;
+}
\ No newline at end of file
@@ -0,0 +1,215 @@
+/**
+ * @file CommandScheduler.h
+ * @brief 通信速度から1周期に送れる量を計算し，送信フレームを割り振る機能
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef COMMAND_SCHEDULER_H
+#define COMMAND_SCHEDULER_H
+
+#include <Arduino.h>
+
+#include "Transport.h"
+#include "FrameQueue.h"
+
+#define SCHED_QUEUE_SIZE 32     /**< 送信を待てるフレームの数 */
+
+#define SCHED_PRIO_HIGH 0       /**< 優先度 高 停止命令など */
+#define SCHED_PRIO_NORMAL 1     /**< 優先度 通常 */
+#define SCHED_PRIO_LOW 2        /**< 優先度 低 表示灯など */
+#define SCHED_PRIO_NUM 3        /**< 優先度の数 */
+
+
+/**
+ * @brief 送信量を計画する Transport
+ *
+ *
+ * ほかの Transport の前に置き，送信フレームをすぐには送らずに待ち行列に積む @n
+ * 制御周期ごとに run() を呼ぶと，通信速度から計算した1周期の送信量(予算)に収まる分だけを
+ * 優先度の高い順，同じ優先度では積んだ順に送る @n
+ * 収まらなかったフレームは次の周期に回し，期限を過ぎたフレームは捨てる
+ *
+ * 上書き可能として積んだフレームは，同じ宛先へのまだ送っていないフレームを置き換える @n
+ * 宛先は次のように判断する
+ *  - FETモジュール (4byte, 6byte): IDと出力ポート 機能指定ビットが出力の設定( FUNC_DIGITAL_OUT ~ FUNC_WAVE_SAWINV )のときのみ
+ *  - 足回りモジュール (8byte): すべて同じ宛先
+ *
+ * 例) 足回りは優先度 高 で毎周期上書きし，表示灯は 優先度 低 で空いた時間に送る
+ * @code
+ *  SerialTransport Uart(&Serial1);
+ *  CommandScheduler Sched(&Uart, 115200, 10);
+ *
+ *  T_UnderBody Omni4(&Sched);
+ *  T_Fets Lamp(&Sched, 0x91);
+ *
+ *  void loop(){
+ *      Sched.setPolicy(SCHED_PRIO_HIGH, 20, true);     // 20[ms] 以内に送れなければ捨てる
+ *      Omni4.moveXY(vX, vY, omega);
+ *
+ *      Sched.setPolicy(SCHED_PRIO_LOW, 0, true);
+ *      Lamp.writeWave(Fets::Square, 500, Fets::Out1);
+ *
+ *      Sched.run();
+ *      Sched.pollFrames();
+ *      delay(10);
+ *  }
+ * @endcode
+ *
+ * @note    1byteはスタートビットとストップビットを含めて10bitとして計算する
+ * @attention パターンの登録のように順番と数に意味があるフレームは上書き可能にしないこと
+ */
+class CommandScheduler : public Transport
+{
+public:
+
+    /**
+     * 送信の統計
+     */
+    struct stats{
+        unsigned long sent;         /**< 送ったフレーム数 */
+        unsigned long deferred;     /**< 予算に収まらず次の周期に回したフレーム数 1フレーム1回まで数える */
+        unsigned long coalesced;    /**< 上書きしたフレーム数 */
+        unsigned long dropped;      /**< 送らずに失ったフレーム数 expired + evicted + rejected */
+        unsigned long expired;      /**< 期限までに送れず run() で捨てたフレーム数 */
+        unsigned long evicted;      /**< 満杯のとき，優先度の高いフレームを積むために捨てた待ち中のフレーム数 */
+        unsigned long rejected;     /**< 満杯で積めず post() が -2 を返したフレーム数 */
+        unsigned int lastBytes;     /**< 前回の run() で送ったbyte数 */
+    };
+
+    /**
+     * コンストラクタ
+     *
+     * @param _link     実際に送受信する通信路
+     * @param baudrate  通信速度[bps]
+     * @param period    run() を呼ぶ周期[ms]
+     */
+    CommandScheduler(Transport *_link, unsigned long baudrate = 115200, unsigned int period = 10);
+
+    /**
+     * 1周期の送信量を直接設定する @n
+     * 半二重でモジュールの応答の時間を空けるときなどに使う
+     *
+     * @param bytes 1周期に送るbyte数 @p FRAME_MAX_LEN 以上
+     */
+    void setBudget(int bytes);
+
+    /**
+     * @return 1周期に送るbyte数
+     */
+    int getBudget();
+
+    /**
+     * sendFrame() で積むフレームの扱いを設定する @n
+     * Fets , UnderBody のメソッドを呼ぶ前に設定する
+     *
+     * @param priority  優先度 SCHED_PRIO_HIGH ~ SCHED_PRIO_LOW
+     * @param deadline  期限[ms] 積んでからこの時間内に送れなければ捨てる @p 0 なら期限なし
+     * @param coalesce  @p true なら同じ宛先のフレームを上書きする
+     */
+    void setPolicy(uint8_t priority, unsigned int deadline = 0, bool coalesce = false);
+
+    /**
+     * フレームを積む
+     *
+     * @param frame     フレーム
+     * @param len       フレームの長さ @p 1 ~ @p FRAME_MAX_LEN
+     * @param priority  優先度 SCHED_PRIO_HIGH ~ SCHED_PRIO_LOW
+     * @param deadline  期限[ms] @p 0 なら期限なし
+     * @param coalesce  @p true なら同じ宛先のフレームを上書きする
+     *
+     * @retval -1   フレームの長さが不正
+     * @retval -2   満杯 優先度の低いフレームもないので捨てた
+     * @retval 0    積んだ
+     * @retval 1    同じ宛先のフレームを上書きした
+     *
+     * @note    満杯のときは，新しいフレームより優先度の低いフレームのうち最も新しいものを捨てて積む @n
+     *          捨てたフレームは stats::evicted に，積めなかった新しいフレームは stats::rejected に数える
+     */
+    int post(const uint8_t *frame, int len, uint8_t priority = SCHED_PRIO_NORMAL, unsigned int deadline = 0, bool coalesce = false);
+
+    /**
+     * setPolicy() の設定でフレームを積む
+     *
+     * @retval true     積んだ，または上書きした
+     * @retval false    フレームの長さが不正，または満杯で捨てた
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    /**
+     * 実際の通信路から1byte読む
+     */
+    int readByte(); //override
+
+    /**
+     * 1周期分のフレームを送る 制御周期ごとに1回呼び出す
+     *
+     * @return  送ったbyte数
+     */
+    int run();
+
+    /**
+     * @return 送信を待っているフレーム数
+     */
+    int count();
+
+    /**
+     * @return 送信の統計
+     */
+    const stats &getStats();
+
+    /**
+     * 送信の統計を消す
+     */
+    void clearStats();
+
+    /**
+     * 上書きの判断に使う宛先を返す
+     *
+     * @param frame     フレーム
+     * @param len       フレームの長さ
+     * @param key       宛先の格納先
+     *
+     * @retval true     上書きできるフレーム
+     * @retval false    上書きできないフレーム
+     */
+    static bool coalesceKey(const uint8_t *frame, int len, uint16_t *key);
+
+private:
+
+    /**
+     * 送信を待つフレーム
+     */
+    struct entry{
+        uint8_t frame[FRAME_MAX_LEN];
+        uint8_t len;                /**< 0 なら送信済み，または捨てた */
+        uint8_t priority;
+        bool coalesce;
+        bool deferred;              /**< 次の周期に回したことがある */
+        uint16_t key;
+        unsigned long deadline;     /**< 期限の時刻 millis() [ms] 0 なら期限なし */
+    };
+
+    /**
+     * 送信済みのフレームを詰める
+     */
+    void compact();
+
+    Transport *link;
+
+    /**
+     * 送信を待つフレーム 積んだ順
+     */
+    entry entries[SCHED_QUEUE_SIZE];
+    uint8_t entryNum;
+
+    int budget;
+
+    uint8_t policyPriority;
+    unsigned int policyDeadline;
+    bool policyCoalesce;
+
+    stats stat;
+};
+
+#endif
\ No newline at end of file
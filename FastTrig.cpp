@@ -0,0 +1,59 @@
+/**
+ * @file FastTrig.cpp
+ * @brief FastTrig クラスメンバの実装
+ */
+
+#include "FastTrig.h"
+
+
+/**
+ * sin の表 0 ~ 90[deg] を 1[deg] 刻み，1.0 を TRIG_ONE とする
+ */
+static const int16_t sinTable[91] = {
+        0,   286,   572,   857,  1143,  1428,  1713,  1997,  2280,  2563,
+     2845,  3126,  3406,  3686,  3964,  4240,  4516,  4790,  5063,  5334,
+     5604,  5872,  6138,  6402,  6664,  6924,  7182,  7438,  7692,  7943,
+     8192,  8438,  8682,  8923,  9162,  9397,  9630,  9860, 10087, 10311,
+    10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+    12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+    14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+    15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+    16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+    16384,
+};
+
+
+int FastTrig::sinQ14(int theta){
+    int sign = 1;
+    int index, frac;
+    int value;
+
+    theta %= 3600;
+    if(theta < 0) theta += 3600;
+
+    if(theta >= 1800){          // 180 ~ 360[deg] は符号を反転する
+        theta -= 1800;
+        sign = -1;
+    }
+    if(theta > 900) theta = 1800 - theta;   // 90 ~ 180[deg] は折り返す
+
+    index = theta / 10;
+    frac = theta % 10;
+
+    value = sinTable[index];
+    if(frac != 0) value += (sinTable[index + 1] - sinTable[index]) * frac / 10;
+
+    return sign * value;
+}
+
+int FastTrig::cosQ14(int theta){
+    return sinQ14((theta % 3600) + 900);
+}
+
+void FastTrig::rotate(long x, long y, int theta, long *rx, long *ry){
+    long s = sinQ14(theta);
+    long c = cosQ14(theta);
+
+    *rx = (c * x - s * y) / TRIG_ONE;
+    *ry = (s * x + c * y) / TRIG_ONE;
+}
\ No newline at end of file
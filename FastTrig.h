@@ -0,0 +1,71 @@
+/**
+ * @file FastTrig.h
+ * @brief 表引きによる整数の三角関数と座標回転
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef FAST_TRIG_H
+#define FAST_TRIG_H
+
+#include <Arduino.h>
+
+#define TRIG_ONE 16384          /**< 三角関数の戻り値の 1.0 に相当する値 */
+
+
+/**
+ * @brief 表引きによる整数の三角関数
+ *
+ *
+ * 0 ~ 90[deg] の1/4周期の sin の表(1[deg]刻み)を線形補間して，
+ * 0.1[deg] 単位の角度の sin , cos を整数で返す @n
+ * double の三角関数を使わないので，制御周期ごとの座標変換に使う
+ *
+ * 角度の単位はすべて [0.1deg] ，反時計回りが正である @n
+ * 誤差は 1.0 に対して最大でおよそ 1/10000 である
+ *
+ * 例)
+ * @code
+ *  long bodyX, bodyY;
+ *
+ *  // フィールド座標系の速度をロボット座標系に回す
+ *  FastTrig::rotate(fieldX, fieldY, -heading, &bodyX, &bodyY);
+ * @endcode
+ */
+class FastTrig
+{
+public:
+
+    /**
+     * sin を返す
+     *
+     * @param theta     角度 [0.1deg] 範囲の制限なし
+     *
+     * @return  sin(theta) * TRIG_ONE
+     */
+    static int sinQ14(int theta);
+
+    /**
+     * cos を返す
+     *
+     * @param theta     角度 [0.1deg] 範囲の制限なし
+     *
+     * @return  cos(theta) * TRIG_ONE
+     */
+    static int cosQ14(int theta);
+
+    /**
+     * ベクトルを回転する
+     *
+     * @param x         ベクトルのX成分
+     * @param y         ベクトルのY成分
+     * @param theta     回転角 [0.1deg] 反時計回りが正
+     * @param rx        回転後のX成分の格納先
+     * @param ry        回転後のY成分の格納先
+     *
+     * @attention   x , y は ±65535 以内とすること (32bitでのあふれ防止)
+     */
+    static void rotate(long x, long y, int theta, long *rx, long *ry);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,132 @@
+/**
+ * @file FetHistory.cpp
+ * @brief FetHistory クラスメンバの実装
+ */
+
+#include "FetHistory.h"
+
+
+FetHistory::FetHistory(){
+    clear();
+}
+
+void FetHistory::record(uint8_t input, uint8_t output, unsigned long time){
+    frames++;
+
+    if(num > 0){
+        entry &last = entries[(head + FET_HISTORY_SIZE - 1) % FET_HISTORY_SIZE];
+
+        if(last.input == input && last.output == output){  // 同じ状態はまとめる
+            if(last.count < 0xFFFF) last.count++;
+            return;
+        }
+    }
+
+    entries[head].time = time;
+    entries[head].input = input;
+    entries[head].output = output;
+    entries[head].count = 1;
+
+    head = (head + 1) % FET_HISTORY_SIZE;
+    if(num < FET_HISTORY_SIZE) num++;
+}
+
+void FetHistory::clear(){
+    head = 0;
+    num = 0;
+    frames = 0;
+}
+
+unsigned long FetHistory::getFrames(){
+    return frames;
+}
+
+int FetHistory::transitions(Fets::portNum inputPort, unsigned long *times, uint8_t *levels, int maxNum){
+    if(inputPort <= Fets::Dammy || inputPort > Fets::In7) return -1;
+
+    uint8_t bit = 0x01 << (inputPort - Fets::In1);
+    int found = 0;
+
+    for(int age=0; age+1<num && found<maxNum; age++){
+        const entry &cur = at(age);
+
+        if((cur.input ^ at(age+1).input) & bit){
+            times[found] = cur.time;
+            if(levels != NULL) levels[found] = (cur.input & bit) ? 1 : 0;
+            found++;
+        }
+    }
+
+    return found;
+}
+
+long FetHistory::pulseWidth(Fets::portNum inputPort, uint8_t level){
+    unsigned long times[3];
+    uint8_t levels[3];
+    int found = transitions(inputPort, times, levels, 3);
+
+    for(int i=0; i+1<found; i++){
+        if(levels[i] != level && levels[i+1] == level){     // level になって，level から戻った
+            return (long)(times[i] - times[i+1]);
+        }
+    }
+
+    return -1;
+}
+
+long FetHistory::levelAge(Fets::portNum inputPort, uint8_t level){
+    if(inputPort <= Fets::Dammy || inputPort > Fets::In7) return -1;
+    if(num == 0) return -1;
+
+    uint8_t bit = 0x01 << (inputPort - Fets::In1);
+    uint8_t current = at(0).input & bit;
+    int age = 0;
+
+    if((current ? 1 : 0) != (level ? 1 : 0)) return -1;
+
+    while(age+1 < num && (at(age+1).input & bit) == current){   // この入力になった記録までさかのぼる
+        age++;
+    }
+
+    return (long)(micros() - at(age).time);
+}
+
+long FetHistory::period(Fets::portNum inputPort){
+    unsigned long times[4];
+    uint8_t levels[4];
+    unsigned long rise[2];
+    int riseNum = 0;
+    int found = transitions(inputPort, times, levels, 4);
+
+    for(int i=0; i<found && riseNum<2; i++){
+        if(levels[i]) rise[riseNum++] = times[i];
+    }
+
+    if(riseNum < 2) return -1;
+
+    return (long)(rise[0] - rise[1]);
+}
+
+int FetHistory::countEdges(Fets::portNum inputPort, unsigned long window, uint8_t edge){
+    if(inputPort <= Fets::Dammy || inputPort > Fets::In7) return -1;
+
+    uint8_t bit = 0x01 << (inputPort - Fets::In1);
+    unsigned long now = micros();
+    int count = 0;
+
+    for(int age=0; age+1<num; age++){
+        const entry &cur = at(age);
+
+        if(now - cur.time > window) break;
+
+        if((cur.input ^ at(age+1).input) & bit){
+            if((cur.input & bit) ? (edge & EDGE_RISE) : (edge & EDGE_FALL)) count++;
+        }
+    }
+
+    return count;
+}
+
+const FetHistory::entry &FetHistory::at(int age){
+    return entries[(head + FET_HISTORY_SIZE - 1 - age) % FET_HISTORY_SIZE];
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+/**
+ * @file FetHistory.h
+ * @brief FETモジュールの入出力状態の履歴
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/18
+ */
+
+#ifndef FET_HISTORY_H
+#define FET_HISTORY_H
+
+#include <Arduino.h>
+
+#include "Fets.h"
+
+#define FET_HISTORY_SIZE 32     /**< 履歴に残す状態の数 */
+
+
+/**
+ * @brief FETモジュールの入出力状態の履歴
+ *
+ *
+ * Fets が受信した正しい状態通知をすべて受信時刻つきで記録するリングバッファ @n
+ * 入力ポートごとの変化の時刻，パルス幅，周期を後から調べられる
+ *
+ * 同じ状態の通知が続いた場合は1つにまとめ，回数だけを数える @n
+ * そのため FET_HISTORY_SIZE は状態の変化の回数で埋まる
+ *
+ * 例) リミットスイッチのチャタリング除去とパルスの計数
+ * @code
+ *  S_Fets Module_S(&Serial1);
+ *  FetHistory History;
+ *
+ *  void setup(){
+ *      Module_S.attachHistory(&History);
+ *  }
+ *
+ *  void loop(){
+ *      Module_S.recvData();
+ *
+ *      // 今の HIGH が 5[ms] 以上続いていれば押されたとみなす
+ *      if(History.levelAge(Fets::In1, HIGH) >= 5000) ...
+ *
+ *      // 直近1秒の立ち上がりの数
+ *      int count = History.countEdges(Fets::In2, 1000000);
+ *  }
+ * @endcode
+ *
+ * @note    時刻はすべて micros() [us] である
+ */
+class FetHistory
+{
+public:
+
+    /**
+     * コンストラクタ
+     */
+    FetHistory();
+
+    /**
+     * 状態通知を記録する @n
+     * Fets が正しい状態通知を受信したときに呼び出す
+     *
+     * @param input     入力状態
+     * @param output    出力状態
+     * @param time      受信時刻[us]
+     */
+    void record(uint8_t input, uint8_t output, unsigned long time);
+
+    /**
+     * 履歴を消去する
+     */
+    void clear();
+
+    /**
+     * @return 記録した状態通知の総数
+     */
+    unsigned long getFrames();
+
+    /**
+     * 入力ポートの変化を新しい順に取得する
+     *
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     * @param times         変化した時刻[us]の格納先 maxNum 個以上
+     * @param levels        変化後の入力 @p 0 or @p 1 の格納先 maxNum 個以上 @n
+     *                      必要なければ NULL
+     * @param maxNum        取得する最大数
+     *
+     * @retval -1           入力ポート指定が不正
+     * @retval 0~maxNum     取得した変化の数
+     */
+    int transitions(Fets::portNum inputPort, unsigned long *times, uint8_t *levels, int maxNum);
+
+    /**
+     * 入力ポートの直近のパルス幅を取得する
+     *
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     * @param level         パルスの入力 @p 0 or @p 1 (LOW or HIGH)
+     *
+     * @retval -1           入力ポート指定が不正，または終わったパルスがない
+     * @retval 0以上        パルス幅[us]
+     *
+     * @note    まだ続いているパルスは対象にしない
+     */
+    long pulseWidth(Fets::portNum inputPort, uint8_t level = HIGH);
+
+    /**
+     * 入力ポートが今の入力になってからの時間を取得する @n
+     * チャタリング除去など，まだ続いているパルスの長さを調べるときに使う
+     *
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     * @param level         入力 @p 0 or @p 1 (LOW or HIGH)
+     *
+     * @retval -1           入力ポート指定が不正，記録がない，または最新の入力が level でない
+     * @retval 0以上        最新の入力が level になってから現在までの時間[us]
+     *
+     * @note    履歴の中で変化していなければ，最も古い記録からの時間を返す
+     */
+    long levelAge(Fets::portNum inputPort, uint8_t level = HIGH);
+
+    /**
+     * 入力ポートの直近の立ち上がりの間隔を取得する
+     *
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     *
+     * @retval -1           入力ポート指定が不正，または立ち上がりが2回ない
+     * @retval 0以上        周期[us] 1000000 をこの値で割ると周波数[Hz]になる
+     */
+    long period(Fets::portNum inputPort);
+
+    /**
+     * 入力ポートの直近の変化を数える
+     *
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     * @param window        数える期間[us] 現在の時刻からさかのぼる
+     * @param edge          数える変化 EDGE_RISE , EDGE_FALL , EDGE_BOTH
+     *
+     * @retval -1           入力ポート指定が不正
+     * @retval 0以上        変化の数
+     *
+     * @note    履歴からあふれた変化は数えられない
+     */
+    int countEdges(Fets::portNum inputPort, unsigned long window, uint8_t edge = EDGE_RISE);
+
+private:
+
+    /**
+     * 1つの状態の記録
+     */
+    struct entry{
+        unsigned long time; /**< この状態を最初に受信した時刻[us] */
+        uint8_t input;      /**< 入力状態 */
+        uint8_t output;     /**< 出力状態 */
+        uint16_t count;     /**< 同じ状態を受信した回数 */
+    };
+
+    /**
+     * 新しい順に記録を返す
+     *
+     * @param age   @p 0 が最新
+     */
+    const entry &at(int age);
+
+    /**
+     * 記録の配列
+     */
+    entry entries[FET_HISTORY_SIZE];
+
+    /**
+     * 次に記録する位置
+     */
+    uint8_t head;
+
+    /**
+     * 記録の数
+     */
+    uint8_t num;
+
+    /**
+     * 記録した状態通知の総数
+     */
+    unsigned long frames;
+};
+
+#endif
\ No newline at end of file
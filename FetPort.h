@@ -0,0 +1,198 @@
+/**
+ * @file FetPort.h
+ * @brief 配線をコンパイル時に固定したFETモジュールのポート操作
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef FET_PORT_H
+#define FET_PORT_H
+
+#include <Arduino.h>
+
+#include "Fets.h"
+
+
+/**
+ * コンパイル時の条件確認 @n
+ * 条件が偽のときは FetStaticCheck<false> が未定義なのでコンパイルエラーになる
+ */
+template <bool> struct FetStaticCheck;
+template <> struct FetStaticCheck<true> {};
+
+
+/**
+ * @brief 配線をコンパイル時に固定したFETモジュールのポート操作クラス
+ *
+ *
+ * 出力ポートと入力ポートをテンプレート引数で指定し，送信と受信は Fets の実体で行う @n
+ * ポート番号の確認はコンパイル時に行われるので，実行時には opCheck() , ipCheck() を通らずに
+ * Fets::sendPort() でフレームを作って sendFrame() に渡す
+ *
+ * 送信は Fets のメソッドと同じ経路なので，出力の停止( LinkMonitor )，待ち行列( FrameQueue )，
+ * 記録( BusRecorder )，計測( TRACE )も同じように働く @n
+ * 入出力状態は Fets の実体のものを読むので，同じモジュールを指す Fets や FetPort と食い違わない
+ *
+ * メソッドは Fets と同じ名前，同じ戻り値であり，ポート指定の引数がないだけである
+ *
+ * 例)
+ * @code
+ *  S_Fets Fet(&Serial1, 0x90);
+ *
+ *  FetPort<Fets::Out3> Lamp(Fet);
+ *  FetPort<Fets::Out1, Fets::In2> Sorenoid(Fet);
+ *
+ *  Lamp.write(0.5);
+ *  Sorenoid.sensorResponce(0, 1);
+ * @endcode
+ *
+ * @tparam OP   出力ポートの番号 Fets::Out1 ~ Fets::Out7
+ * @tparam IP   入力ポートの番号 Fets::In1 ~ Fets::In7 @n
+ *              指定しなくても良い
+ *
+ * @attention   Fets::Out7 で PWM出力 , 波出力を使用したり，
+ *              入力ポート指定なしでセンサ応答を使用するとコンパイルエラーになる
+ * @attention   元の Fets 実体より長く使用してはならない
+ */
+template <Fets::portNum OP, Fets::portNum IP = Fets::None>
+class FetPort
+{
+    enum {
+        checkOutput = sizeof(FetStaticCheck<(OP > Fets::None && OP < Fets::Dammy)>),
+        checkInput  = sizeof(FetStaticCheck<(IP == Fets::None || (IP > Fets::Dammy && IP <= Fets::In7))>)
+    };
+
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _module   送受信に使用する Fets の実体
+     */
+    FetPort(Fets &_module) : module(_module){}
+
+    /**
+     * digital出力を行う
+     * @see Fets::write(int, Fets::portNum)
+     */
+    int write(int duty){
+        if(duty != 0 && duty != 1) return -2;
+
+        return module.sendPort(FUNC_DIGITAL_OUT, OP, duty & 0x01);
+    }
+
+    /**
+     * PWM出力を行う
+     * @see Fets::write(double, Fets::portNum)
+     */
+    int write(double duty){
+        (void)sizeof(FetStaticCheck<(OP != Fets::Out7)>);
+        if(!(duty >= 0.0)) return -3;
+        if(duty > 1.0) return -4;
+
+        return module.sendPort(FUNC_PWM_OUT, OP, (uint8_t)(duty*127.0));
+    }
+
+    /**
+     * 12bitの出力値でPWM出力を行う
+     * @see Fets::writeDuty()
+     */
+    int writeDuty(uint16_t duty){
+        (void)sizeof(FetStaticCheck<(OP != Fets::Out7)>);
+        if(duty > MAX_DUTY) return -3;
+
+        uint8_t parameter;
+
+        if(Fets::compactDuty(duty, &parameter)){
+            return module.sendPort(FUNC_PWM_OUT, OP, parameter);
+        }
+        return module.sendPort(FUNC_PWM_OUT, OP, duty, true);
+    }
+
+    /**
+     * センサ応答を設定する
+     * @see Fets::sensorResponce()
+     */
+    int sensorResponce(uint8_t actInput, uint8_t actOutput){
+        (void)sizeof(FetStaticCheck<(IP != Fets::None)>);
+
+        int ret = module.sendPort(FUNC_SENSOR_RES, OP, Fets::sensorParam(actInput, actOutput, IP));
+        if(ret < 0) return ret;
+
+        return ((module.outputState >> (OP - Fets::Out1)) & 0x01) == actOutput;
+    }
+
+    /**
+     * センサトリガーを設定する
+     * @see Fets::sensorTrigger()
+     */
+    int sensorTrigger(uint8_t actInput, uint8_t actOutput){
+        (void)sizeof(FetStaticCheck<(IP != Fets::None)>);
+
+        int ret = module.sendPort(FUNC_SENSOR_TRG, OP, Fets::sensorParam(actInput, actOutput, IP));
+        if(ret < 0) return ret;
+
+        return ((module.outputState >> (OP - Fets::Out1)) & 0x01) == actOutput;
+    }
+
+    /**
+     * 特定の波形で出力する
+     * @see Fets::writeWave()
+     */
+    int writeWave(Fets::waveform form, int period){
+        (void)sizeof(FetStaticCheck<(OP != Fets::Out7)>);
+        if(period < 100)        return -3;
+        if(period > 10000)      return -4;
+
+        return module.sendPort((uint8_t)form, OP, (uint8_t)(period/100));
+    }
+
+    /**
+     * 1[ms]単位の周期で特定の波形を出力する
+     * @see Fets::writeWaveFine()
+     */
+    int writeWaveFine(Fets::waveform form, int period){
+        (void)sizeof(FetStaticCheck<(OP != Fets::Out7)>);
+        if(period < 100)        return -3;
+        if(period > 10000)      return -4;
+
+        uint8_t parameter;
+
+        if(Fets::compactPeriod(period, &parameter)){
+            return module.sendPort((uint8_t)form, OP, parameter);
+        }
+        return module.sendPort((uint8_t)form, OP, (uint16_t)period, true);
+    }
+
+    /**
+     * 出力ポートの出力状態を取得する
+     * @see Fets::getOutputState()
+     */
+    int getOutputState(){
+        module.recvData();
+        return (module.outputState >> (OP - Fets::Out1)) & 0x01;
+    }
+
+    /**
+     * 入力状態を取得する
+     *
+     * @param inputPort     状態を読みたい入力ポートの番号 @n
+     *                      指定しなければテンプレート引数の入力ポート，それもなければすべての入力ポート
+     * @see Fets::getInputState()
+     */
+    int getInputState(Fets::portNum inputPort = IP){
+        module.recvData();
+        if(inputPort <= Fets::Dammy || inputPort > Fets::In7) return (int)module.inputState;
+
+        return (module.inputState >> (inputPort - Fets::In1)) & 0x01;
+    }
+
+private:
+
+    /**
+     * 送受信に使用する Fets の実体
+     */
+    Fets &module;
+};
+
+#endif
@@ -4,14 +4,55 @@
  */
 
 #include "Fets.h"
+#include "FetHistory.h"
+#include "BusRecorder.h"
+#include "LinkMonitor.h"
+#include "Trace.h"
 
 
-char Fets::mode = MODE_INIT;
+char Fets::modeId[MODE_TABLE_SIZE] = {};
+char Fets::modeTable[MODE_TABLE_SIZE] = {};
+uint8_t Fets::modeNum = 0;
+char Fets::modeConflict = MODE_CONFLICT;
+
+
+/*
+ * 出力を切る指令か
+ */
+static bool isOffCommand(uint8_t funcBit, uint16_t parameter){
+    switch(funcBit){
+    case FUNC_DIGITAL_OUT:
+    case FUNC_PWM_OUT:
+        return parameter == 0;
+    case FUNC_PATTERN_RUN:
+        return parameter == PATTERN_RUN_STOP;
+    }
+    return false;
+}
 
 Fets::Fets(char _id, portNum outputPort, portNum inputPort){
 
     char newMode = MODE_INIT;
 
+    id = _id;
+    mode = modeOf(_id);
+
+    inputState = 0;
+    outputState = 0;
+    stateValid = false;
+    riseMask = 0;
+    fallMask = 0;
+    inputEvents = 0;
+    eventTime = 0;
+    handler = NULL;
+    history = NULL;
+    recorder = NULL;
+    monitor = NULL;
+    failsafe = false;
+    for(int i=0; i<4; i++){
+        dataBuff[i] = 0;
+    }
+
     if(outputPort == None) {       // ポートの指定がない時
         newMode = MODE_MODULE;
     }
@@ -19,14 +60,13 @@ Fets::Fets(char _id, portNum outputPort, portNum inputPort){
         newMode = MODE_PORT;
     }
 
-    if(mode != MODE_INIT && newMode != mode) {  // mode 1 と mode 2,3 は両立不可
-        mode = MODE_CONFLICT;
+    if(*mode != MODE_INIT && newMode != *mode) {  // 同じIDで mode 1 と mode 2,3 は両立不可
+        *mode = MODE_CONFLICT;
         opNum = None;
         ipNum = None;
     }
     else {
-        mode = newMode;
-        id = _id;
+        *mode = newMode;
 
         opNum = outputPort;
         ipNum = inputPort;
@@ -34,6 +74,11 @@ Fets::Fets(char _id, portNum outputPort, portNum inputPort){
 }
 
 
+Fets::Port Fets::port(portNum outputPort, portNum inputPort){
+    return Port(this, outputPort, inputPort);
+}
+
+
 int Fets::write(int duty, portNum outputPort){
     if((outputPort = opCheck(outputPort)) == None) return -1;
     if(duty != 0 && duty != 1) return -2;
@@ -44,17 +89,30 @@ int Fets::write(int duty, portNum outputPort){
 int Fets::write(double duty, portNum outputPort){
     if((outputPort = opCheck(outputPort)) == None) return -1;
     if(outputPort == Out7) return -2;
-    if(duty < 0.0) return -3;
+    if(!(duty >= 0.0)) return -3;     // NaN も除く
     if(duty > 1.0) return -4;
 
     return sendData(FUNC_PWM_OUT, outputPort, (uint8_t)(duty*127.0));
 }
 
+int Fets::writeDuty(uint16_t duty, portNum outputPort){
+    uint8_t parameter;
+
+    if((outputPort = opCheck(outputPort)) == None) return -1;
+    if(outputPort == Out7) return -2;
+    if(duty > MAX_DUTY) return -3;
+
+    if(compactDuty(duty, &parameter)) return sendData(FUNC_PWM_OUT, outputPort, parameter);
+
+    return sendData(FUNC_PWM_OUT, outputPort, duty, true);
+}
+
 int Fets::sensorResponce(uint8_t actInput, uint8_t actOutput, portNum outputPort, portNum inputPort){
     if((outputPort = opCheck(outputPort)) == None) return -1;
     if((inputPort  = ipCheck(inputPort))  == None) return -2;
 
-    sendData(FUNC_SENSOR_RES, outputPort, 0x7F & (((actInput & 0x01) << 4) | ((actOutput & 0x01) << 3) | ((inputPort - Dammy) & 0x07)));
+    int ret = sendData(FUNC_SENSOR_RES, outputPort, sensorParam(actInput, actOutput, inputPort));
+    if(ret < 0) return ret;
 
     return ((outputState >> (outputPort - 1)) & 0x01) == actOutput;
 }
@@ -63,7 +121,8 @@ int Fets::sensorTrigger(uint8_t actInput, uint8_t actOutput, portNum outputPort,
     if((outputPort = opCheck(outputPort)) == None) return -1;
     if((inputPort  = ipCheck(inputPort))  == None) return -2;
 
-    sendData(FUNC_SENSOR_TRG, outputPort, 0x7F & (((actInput & 0x01) << 4) | ((actOutput & 0x01) << 3) | ((inputPort - Dammy) & 0x07)));
+    int ret = sendData(FUNC_SENSOR_TRG, outputPort, sensorParam(actInput, actOutput, inputPort));
+    if(ret < 0) return ret;
 
     return ((outputState >> (outputPort - 1)) & 0x01) == actOutput;
 }
@@ -77,10 +136,102 @@ int Fets::writeWave(waveform form, int period, portNum outputPort){
     return sendData((uint8_t)form, outputPort, (uint8_t)(period/100));
 }
 
+int Fets::writeWaveFine(waveform form, int period, portNum outputPort){
+    uint8_t parameter;
+
+    if((outputPort = opCheck(outputPort)) == None) return -1;
+    if(outputPort == Out7)  return -2;
+    if(period < 100)        return -3;
+    if(period > 10000)      return -4;
+
+    if(compactPeriod(period, &parameter)) return sendData((uint8_t)form, outputPort, parameter);
+
+    return sendData((uint8_t)form, outputPort, (uint16_t)period, true);
+}
+
+int Fets::uploadPattern(const patternSeg *seg, int num, portNum outputPort){
+    int lastTime = 0;
+
+    if((outputPort = opCheck(outputPort)) == None) return -1;
+    if(outputPort == Out7) return -2;
+    if(num < 1 || num > PATTERN_MAX_SEG) return -3;
+
+    for(int i=0; i<num; i++){
+        if(!(seg[i].duty >= 0.0 && seg[i].duty <= 1.0)) return -4;
+        if(seg[i].time < PATTERN_TIME_UNIT || seg[i].time > PATTERN_TIME_UNIT*127) return -5;
+    }
+
+    int ret = sendData(FUNC_PATTERN_RUN, outputPort, PATTERN_RUN_STOP);
+    if(ret < 0) return ret;
+
+    for(int i=0; i<num; i++){
+        int time = seg[i].time / PATTERN_TIME_UNIT;
+
+        if((ret = sendData(FUNC_PATTERN_DUTY, outputPort, (uint8_t)(seg[i].duty*127.0))) < 0) return ret;
+        if(time != lastTime){       // 長さが同じなら前の区間の長さが使われる
+            if((ret = sendData(FUNC_PATTERN_TIME, outputPort, (uint8_t)time)) < 0) return ret;
+            lastTime = time;
+        }
+    }
+
+    return 0;
+}
+
+int Fets::uploadPattern(const uint8_t *table, int num, int time, portNum outputPort){
+    if((outputPort = opCheck(outputPort)) == None) return -1;
+    if(outputPort == Out7) return -2;
+    if(num < 1 || num > PATTERN_MAX_SEG) return -3;
+    for(int i=0; i<num; i++){
+        if(table[i] > 127) return -4;
+    }
+    if(time < PATTERN_TIME_UNIT || time > PATTERN_TIME_UNIT*127) return -5;
+
+    int ret;
+
+    if((ret = sendData(FUNC_PATTERN_RUN, outputPort, PATTERN_RUN_STOP)) < 0) return ret;
+    if((ret = sendData(FUNC_PATTERN_DUTY, outputPort, table[0])) < 0) return ret;
+    if((ret = sendData(FUNC_PATTERN_TIME, outputPort, (uint8_t)(time / PATTERN_TIME_UNIT))) < 0) return ret;
+    for(int i=1; i<num; i++){
+        if((ret = sendData(FUNC_PATTERN_DUTY, outputPort, table[i])) < 0) return ret;
+    }
+
+    return 0;
+}
+
+int Fets::startPattern(bool loop, int phase, portNum outputPort){
+    if((outputPort = opCheck(outputPort)) == None) return -1;
+    if(outputPort == Out7) return -2;
+    if(phase < 0 || phase >= PATTERN_MAX_SEG) return -3;
+
+    return sendData(FUNC_PATTERN_RUN, outputPort, (loop ? PATTERN_RUN_LOOP : 0) | (phase & 0x1F));
+}
+
+int Fets::stopPattern(portNum outputPort){
+    if((outputPort = opCheck(outputPort)) == None) return -1;
+    if(outputPort == Out7) return -2;
+
+    return sendData(FUNC_PATTERN_RUN, outputPort, PATTERN_RUN_STOP);
+}
+
+int Fets::allOff(){
+    int ret = 0;
+
+    if(*mode == MODE_CONFLICT) return -1;
+
+    for(int i=Out1; i<Out7; i++){
+        if(sendData(FUNC_PATTERN_RUN, (portNum)i, PATTERN_RUN_STOP) < 0) ret = FET_ERR_DROPPED;
+    }
+    for(int i=Out1; i<=Out7; i++){
+        if(sendData(FUNC_DIGITAL_OUT, (portNum)i, 0) < 0) ret = FET_ERR_DROPPED;
+    }
+
+    return ret;
+}
+
 
 
 int Fets::getOutputState(portNum outputPort){
-    if(mode == MODE_CONFLICT) return -1;
+    if(*mode == MODE_CONFLICT) return -1;
 
     recvData();
     if((outputPort = opCheck(outputPort)) == None) return (int)outputState;
@@ -89,7 +240,7 @@ int Fets::getOutputState(portNum outputPort){
 }
 
 int Fets::getInputState(portNum inputPort){
-    if(mode == MODE_CONFLICT) return -1;
+    if(*mode == MODE_CONFLICT) return -1;
 
     recvData();
     if((inputPort = ipCheck(inputPort)) == None) return (int)inputState;
@@ -97,52 +248,233 @@ int Fets::getInputState(portNum inputPort){
     return (inputState >> (inputPort - In1)) & 0x01;
 }
 
-int Fets::sendData(uint8_t funcBit, portNum outputPort, uint8_t parameter){
-    uint8_t str[4] = {};
-
+int Fets::sendData(uint8_t funcBit, portNum outputPort, uint16_t parameter, bool extended){
     if((outputPort = opCheck(outputPort)) == None) return -1;
 
-    str[0] = ((funcBit << 3) & 0x78) | (outputPort & 0x07);
-    str[1] = parameter;
-    str[2] = str[0] ^ str[1];
-    str[3] = id;
+    return sendPort(funcBit, outputPort, parameter, extended);
+}
 
-    for(int i=0; i<4; i++){
-        send(str[i]);
+int Fets::sendPort(uint8_t funcBit, portNum outputPort, uint16_t parameter, bool extended){
+    TRACE(TRACE_FET_SEND);
+
+    uint8_t str[6] = {};
+    int len;
+
+    if(failsafe && !isOffCommand(funcBit, parameter)) return FET_ERR_LOCKED;
+
+    if(extended){
+        len = makeFrameEx(str, funcBit, outputPort, parameter, id);
+    }
+    else{
+        len = makeFrame(str, funcBit, outputPort, (uint8_t)parameter, id);
     }
+
+    if(!sendFrame(str, len)) return FET_ERR_DROPPED;
+
+    if(recorder != NULL) recorder->record(REC_FET_TX, str, len);     // 捨てたフレームは記録しない
+
     return 0;
 }
 
+bool Fets::sendFrame(const uint8_t *frame, int len){
+    for(int i=0; i<len; i++){
+        send(frame[i]);
+    }
+    return true;
+}
+
 int Fets::recvData(){
-    if(mode == MODE_CONFLICT) return -1;
+    TRACE(TRACE_FET_RECV);
+
+    if(*mode == MODE_CONFLICT) return -1;
 
     int getNum = 0;
     int data;
 
     while((data = recieve()) != -1){
+        if(recorder != NULL) recorder->recordRx((uint8_t)data);
+        parseByte((uint8_t)data);
+        getNum++;
+    }
 
-        dataBuff[3] = (char)data;
+    return getNum;
+}
 
-        if(dataBuff[3] == id
-        && dataBuff[2] == (dataBuff[0] ^ dataBuff[1])){
-            outputState = dataBuff[1];
-            inputState  = dataBuff[0];
-        }
+void Fets::parseByte(uint8_t data){
+    if(*mode == MODE_CONFLICT) return;
 
-        for(int i=0;i<3;i++){
-            dataBuff[i] = dataBuff[i+1];
-        }
+    dataBuff[3] = data;
 
-        getNum++;
+    if(isStateFrame(dataBuff, id)){
+        updateState(dataBuff[0], dataBuff[1]);
+        if(monitor != NULL) monitor->frameOk((uint8_t)id);
+    }
+    else if(monitor != NULL && dataBuff[3] == (uint8_t)id){   // IDは最上位bitが立っているので他のbyteと区別できる
+        monitor->frameError((uint8_t)id);
     }
 
-    return getNum;
+    for(int i=0;i<3;i++){
+        dataBuff[i] = dataBuff[i+1];
+    }
 }
 
 
+int Fets::watchInput(portNum inputPort, uint8_t edge){
+    if(inputPort <= Dammy || inputPort > In7) return -1;
+
+    uint8_t bit = 0x01 << (inputPort - In1);
+
+    riseMask = (edge & EDGE_RISE) ? (riseMask | bit) : (riseMask & ~bit);
+    fallMask = (edge & EDGE_FALL) ? (fallMask | bit) : (fallMask & ~bit);
+
+    return 0;
+}
+
+int Fets::unwatchInput(portNum inputPort){
+    return watchInput(inputPort, 0);
+}
+
+void Fets::onInputChange(inputHandler func){
+    handler = func;
+}
+
+uint8_t Fets::takeInputEvents(unsigned long *time){
+    uint8_t events = inputEvents;
+
+    if(time != NULL) *time = eventTime;
+    inputEvents = 0;
+
+    return events;
+}
+
+void Fets::attachHistory(FetHistory *_history){
+    history = _history;
+}
+
+void Fets::attachRecorder(BusRecorder *_recorder){
+    recorder = _recorder;
+}
+
+void Fets::attachMonitor(LinkMonitor *_monitor){
+    monitor = _monitor;
+}
+
+void Fets::setFailsafe(bool lock){
+    failsafe = lock;
+}
+
+bool Fets::isFailsafe(){
+    return failsafe;
+}
+
+void Fets::updateState(uint8_t input, uint8_t output){
+    uint8_t changed = 0;
+    unsigned long now = micros();
+
+    if(history != NULL) history->record(input, output, now);
+
+    if(stateValid){
+        changed = ((input & ~inputState) & riseMask)
+                | ((~input & inputState) & fallMask);
+    }
+
+    outputState = output;
+    inputState  = input;
+    stateValid  = true;
+
+    if(changed){
+        eventTime = now;
+        inputEvents |= changed;
+
+        if(handler != NULL) handler(changed, input, eventTime);
+    }
+}
+
+int Fets::makeFrame(uint8_t *frame, uint8_t funcBit, portNum outputPort, uint8_t parameter, char _id){
+    frame[0] = ((funcBit << 3) & 0x78) | (outputPort & 0x07);
+    frame[1] = parameter;
+    frame[2] = frame[0] ^ frame[1];
+    frame[3] = (uint8_t)_id;
+
+    return 4;
+}
+
+int Fets::makeFrameEx(uint8_t *frame, uint8_t funcBit, portNum outputPort, uint16_t parameter, char _id){
+    frame[0] = ((FUNC_EXTENDED << 3) & 0x78) | (outputPort & 0x07);
+    frame[1] = funcBit & 0x7F;
+    frame[2] = (parameter >> 7) & 0x7F;
+    frame[3] = parameter & 0x7F;
+    frame[4] = frame[0] ^ frame[1] ^ frame[2] ^ frame[3];
+    frame[5] = (uint8_t)_id;
+
+    return 6;
+}
+
+bool Fets::compactDuty(uint16_t duty, uint8_t *parameter){
+    uint8_t compact = (uint8_t)((duty*127UL + MAX_DUTY/2) / MAX_DUTY);
+
+    *parameter = compact;
+
+    return (compact*(unsigned long)MAX_DUTY + 63) / 127 == duty;   // 7bitの値から戻して同じ値になるか
+}
+
+bool Fets::compactPeriod(int period, uint8_t *parameter){
+    *parameter = (uint8_t)(period/100);
+
+    return period % 100 == 0 && period/100 <= 0x7F;
+}
+
+int Fets::decodeFrame(const uint8_t *frame, int len, uint8_t *funcBit, portNum *outputPort, uint16_t *parameter, char *_id){
+    if(len < 4) return -1;
+    if(frame[0] & 0x80) return -1;
+
+    *funcBit = (frame[0] >> 3) & 0x0F;
+    *outputPort = (portNum)(frame[0] & 0x07);
+
+    if(*funcBit != FUNC_EXTENDED){
+        if(frame[2] != (frame[0] ^ frame[1])) return -1;
+
+        *parameter = frame[1];
+        *_id = (char)frame[3];
+        return 4;
+    }
+
+    if(len < 6) return -1;
+    if((frame[1] | frame[2] | frame[3]) & 0x80) return -1;
+    if(frame[4] != (frame[0] ^ frame[1] ^ frame[2] ^ frame[3])) return -1;
+
+    *funcBit = frame[1];
+    *parameter = ((uint16_t)frame[2] << 7) | frame[3];
+    *_id = (char)frame[5];
+    return 6;
+}
+
+uint8_t Fets::sensorParam(uint8_t actInput, uint8_t actOutput, portNum inputPort){
+    return 0x7F & (((actInput & 0x01) << 4) | ((actOutput & 0x01) << 3) | ((inputPort - Dammy) & 0x07));
+}
+
+bool Fets::isStateFrame(const uint8_t *frame, char _id){
+    return frame[3] == (uint8_t)_id
+        && frame[2] == (frame[0] ^ frame[1]);
+}
+
+char *Fets::modeOf(char _id){
+
+    for(int i=0; i<modeNum; i++){
+        if(modeId[i] == _id) return &modeTable[i];
+    }
+
+    if(modeNum >= MODE_TABLE_SIZE) return &modeConflict;
+
+    modeId[modeNum] = _id;
+    modeTable[modeNum] = MODE_INIT;
+
+    return &modeTable[modeNum++];
+}
+
 Fets::portNum Fets::ipCheck(portNum inputPort){
 
-    if(mode == MODE_CONFLICT){
+    if(*mode == MODE_CONFLICT){
         return None;
     }
     else if(inputPort > Dammy && inputPort <= In7){
@@ -157,7 +489,7 @@ Fets::portNum Fets::ipCheck(portNum inputPort){
 
 Fets::portNum Fets::opCheck(portNum outputPort){
     
-    if(mode == MODE_CONFLICT){
+    if(*mode == MODE_CONFLICT){
         return None;
     }
     else if(outputPort > None && outputPort < Dammy){
@@ -168,4 +500,57 @@ Fets::portNum Fets::opCheck(portNum outputPort){
     }
 
     return None;
+}
+
+
+Fets::Port::Port(Fets *_module, portNum outputPort, portNum inputPort){
+    module = _module;
+    opNum = outputPort;
+    ipNum = inputPort;
+}
+
+int Fets::Port::write(int duty){
+    return module->write(duty, (portNum)opNum);
+}
+
+int Fets::Port::write(double duty){
+    return module->write(duty, (portNum)opNum);
+}
+
+int Fets::Port::sensorResponce(uint8_t actInput, uint8_t actOutput){
+    return module->sensorResponce(actInput, actOutput, (portNum)opNum, (portNum)ipNum);
+}
+
+int Fets::Port::sensorTrigger(uint8_t actInput, uint8_t actOutput){
+    return module->sensorTrigger(actInput, actOutput, (portNum)opNum, (portNum)ipNum);
+}
+
+int Fets::Port::writeWave(waveform form, int period){
+    return module->writeWave(form, period, (portNum)opNum);
+}
+
+int Fets::Port::uploadPattern(const patternSeg *seg, int num){
+    return module->uploadPattern(seg, num, (portNum)opNum);
+}
+
+int Fets::Port::uploadPattern(const uint8_t *table, int num, int time){
+    return module->uploadPattern(table, num, time, (portNum)opNum);
+}
+
+int Fets::Port::startPattern(bool loop, int phase){
+    return module->startPattern(loop, phase, (portNum)opNum);
+}
+
+int Fets::Port::stopPattern(){
+    return module->stopPattern((portNum)opNum);
+}
+
+int Fets::Port::getOutputState(){
+    return module->getOutputState((portNum)opNum);
+}
+
+int Fets::Port::getInputState(portNum inputPort){
+    if(inputPort == None) inputPort = (portNum)ipNum;
+
+    return module->getInputState(inputPort);
 }
\ No newline at end of file
@@ -10,6 +10,10 @@
 
 #include <Arduino.h>
 
+class FetHistory;
+class BusRecorder;
+class LinkMonitor;
+
 #define DEF_ID 0x90             /**< デフォルトID */
 
 #define FUNC_DIGITAL_OUT 0x01   /**< 機能指定ビット デジタル出力 */
@@ -21,12 +25,32 @@
 #define FUNC_WAVE_TRI 0x07      /**< 機能指定ビット 三角波出力 */
 #define FUNC_WAVE_SAW 0x08      /**< 機能指定ビット ノコギリ波出力 */
 #define FUNC_WAVE_SAWINV 0x09   /**< 機能指定ビット 逆ノコギリ波出力 */
+#define FUNC_PATTERN_DUTY 0x0A  /**< 機能指定ビット パターン区間の追加 パラメータは出力値 */
+#define FUNC_PATTERN_TIME 0x0B  /**< 機能指定ビット 最後に追加したパターン区間の長さ パラメータは PATTERN_TIME_UNIT 単位 */
+#define FUNC_PATTERN_RUN 0x0C   /**< 機能指定ビット パターンの開始/停止 */
+#define FUNC_EXTENDED 0x0D      /**< 機能指定ビット 拡張フレーム 2byte目が本来の機能指定ビット */
+
+#define MAX_DUTY 4095           /**< 拡張フレームでのPWM出力値の最大値(12bit) */
+
+#define EDGE_RISE 0x01          /**< 入力変化の通知 LOW から HIGH */
+#define EDGE_FALL 0x02          /**< 入力変化の通知 HIGH から LOW */
+#define EDGE_BOTH 0x03          /**< 入力変化の通知 両方 */
+
+#define PATTERN_MAX_SEG 16      /**< モジュールに登録できるパターン区間の数 */
+#define PATTERN_TIME_UNIT 10    /**< パターン区間の長さの単位[ms] */
+#define PATTERN_RUN_STOP 0x40   /**< パターン開始/停止のパラメータ 停止してパターンを消去する */
+#define PATTERN_RUN_LOOP 0x20   /**< パターン開始/停止のパラメータ 繰り返す 下位5ビットは開始区間 */
 
 #define MODE_INIT 0             /**< クラスモード 初期化状態 */
 #define MODE_CONFLICT -1        /**< クラスモード 指定の競合 */
 #define MODE_MODULE 1           /**< クラスモード モジュール */
 #define MODE_PORT 2             /**< クラスモード ポート */
 
+#define MODE_TABLE_SIZE 8       /**< モードを記録できるモジュールIDの数 */
+
+#define FET_ERR_LOCKED -10      /**< 送信エラー LinkMonitor が途絶を検出して出力を止めている */
+#define FET_ERR_DROPPED -11     /**< 送信エラー 待ち行列が満杯などで送れず，フレームを捨てた */
+
 
 /** 
  * @brief FETモジュール操作クラス
@@ -37,9 +61,15 @@
  *
  * このクラス内の公開メソッドが主機能すべてである @n
  *
- * @note すべての公開メソッドはそのまま通信を行うので割り込みなどには注意
- * @note すべての通信情報は 4byte である
- * @note シリアル通信115200[bps]で制御周期が10[ms]のとき， 36メソッド/回未満にするべきである
+ * @note すべての公開メソッドはそのまま通信を行うので割り込みなどには注意 @n
+ *       割り込みから使用する場合は送信を FrameQueue に積む拡張クラスを使う
+ * @note すべての通信情報は 4byte である @n
+ *       ただし writeDuty() , writeWaveFine() で細かいPWM出力値や周期を送るときは 6byte の拡張フレーム( FUNC_EXTENDED )になる @n
+ *       拡張フレームは FUNC_EXTENDED を解釈するファームウェアのモジュールだけが受け付ける
+ *       従来のファームウェアのモジュールには，ほかのメソッドだけを使う
+ * @note シリアル通信115200[bps]で制御周期が10[ms]のとき，1周期に送れるのは 115byte (4byte のフレームで28メソッド)である @n
+ *       1byteはスタートビットとストップビットを含めて10bitになる @n
+ *       超える可能性がある場合は CommandScheduler で優先度をつけて1周期の送信量を制限する
  *
  * @remarks 拡張クラスでデータ送受信を実装する必要がある
  *
@@ -93,6 +123,147 @@ public:
         InvSawtooth = FUNC_WAVE_SAWINV, /**< 逆ノコギリ波 */
     };
 
+    /**
+     * 入力変化の通知を受ける関数の型
+     *
+     * @param changed   変化を通知する入力ポート 右から入力ポート1
+     * @param state     変化後のすべての入力ポートの状態 右から入力ポート1
+     * @param time      変化を受信した時刻 micros() [us]
+     */
+    typedef void (*inputHandler)(uint8_t changed, uint8_t state, unsigned long time);
+
+    /**
+     * 出力パターンの区間 @n
+     * Fets::uploadPattern() で使用する
+     */
+    struct patternSeg{
+        double duty;    /**< 出力値 @p 0.0 ~ @p 1.0 */
+        int time;       /**< 区間の長さ[ms] @p 10 ~ @p 1270 PATTERN_TIME_UNIT 単位に切り捨てられる */
+    };
+
+    /**
+     * @brief ポート操作ハンドル
+     *
+     * モジュールとして実体化した Fets のポートを1つだけ操作する軽量なハンドル @n
+     * Fets::port() で取得する
+     *
+     * 通信・受信バッファ・入出力状態はすべて元の Fets 実体と共有するので，
+     * ポートごとに S_Fets を実体化するよりRAMの使用量が少なく，受信処理も重複しない
+     *
+     * 例)
+     * @code
+     *  S_Fets Module_S(&Serial1);
+     *  Fets::Port Sorenoid1 = Module_S.port(Fets::Out1, Fets::In1);
+     *
+     *  Sorenoid1.sensorResponce(0, 1);
+     * @endcode
+     *
+     * @note    各メソッドの戻り値は Fets の同名メソッドと同じである
+     * @attention 元の Fets 実体より長く使用してはならない
+     */
+    class Port
+    {
+    public:
+
+        /**
+         * コンストラクタ
+         *
+         * @param _module       操作する Fets の実体
+         * @param outputPort    使用する出力ポートの番号 Fets::Out1 ~ Fets::Out7
+         * @param inputPort     使用する入力ポートの番号 Fets::In1 ~ Fets::In7 @n
+         *                      指定しなくても良い
+         */
+        Port(Fets *_module, portNum outputPort, portNum inputPort = None);
+
+        /**
+         * digital出力を行う
+         * @param duty  出力値 @p 0 or @p 1 (LOW or HIGH)
+         * @see Fets::write(int, portNum)
+         */
+        int write(int duty);
+
+        /**
+         * PWM出力を行う
+         * @param duty  出力値 @p 0.0 ~ @p 1.0
+         * @see Fets::write(double, portNum)
+         */
+        int write(double duty);
+
+        /**
+         * センサ応答を設定する
+         * @see Fets::sensorResponce()
+         */
+        int sensorResponce(uint8_t actInput, uint8_t actOutput);
+
+        /**
+         * センサトリガーを設定する
+         * @see Fets::sensorTrigger()
+         */
+        int sensorTrigger(uint8_t actInput, uint8_t actOutput);
+
+        /**
+         * 特定の波形で出力する
+         * @see Fets::writeWave()
+         */
+        int writeWave(waveform form, int period);
+
+        /**
+         * 出力パターンをモジュールに登録する
+         * @see Fets::uploadPattern()
+         */
+        int uploadPattern(const patternSeg *seg, int num);
+
+        /**
+         * 出力値の表を出力パターンとしてモジュールに登録する
+         * @see Fets::uploadPattern()
+         */
+        int uploadPattern(const uint8_t *table, int num, int time);
+
+        /**
+         * 登録した出力パターンを開始する
+         * @see Fets::startPattern()
+         */
+        int startPattern(bool loop = true, int phase = 0);
+
+        /**
+         * 出力パターンを停止する
+         * @see Fets::stopPattern()
+         */
+        int stopPattern();
+
+        /**
+         * 出力ポートの出力状態を取得する
+         * @see Fets::getOutputState()
+         */
+        int getOutputState();
+
+        /**
+         * 入力状態を取得する
+         *
+         * @param inputPort     状態を読みたい入力ポートの番号 @n
+         *                      指定しなければハンドルの入力ポート，ハンドルにもなければすべての入力ポート
+         * @see Fets::getInputState()
+         */
+        int getInputState(portNum inputPort = None);
+
+    private:
+
+        /**
+         * 操作する Fets の実体
+         */
+        Fets *module;
+
+        /**
+         * 出力ポートの番号
+         */
+        uint8_t opNum;
+
+        /**
+         * 入力ポートの番号
+         */
+        uint8_t ipNum;
+    };
+
     /**
      * コンストラクタ
      *
@@ -114,12 +285,28 @@ public:
      *                      なおいずれの実体でもIDが同じなら getInputState() , getOutputState() で得られるポート情報は同じになる
      *
      * @attention   モジュールとしての実体を複数作ったり，ポート指定での実体を複数作ることは可能だが
-     * @attention   モジュール実体とポート実体を混合させるのは不可能
-     * @attention   モード干渉としてすべての公開メソッドで -1 を返す(はず)
+     * @attention   同じIDでモジュール実体とポート実体を混合させるのは不可能
+     * @attention   モード干渉としてそのIDのすべての公開メソッドで -1 を返す(はず)
+     * @note        モードはIDごとに管理するので，IDの違うモジュールであれば
+     *              モジュール実体とポート実体を混合させてもよい
+     * @note        MODE_TABLE_SIZE を超える種類のIDを使用した場合，超えた実体はモード干渉となる
      *
      */
     Fets(char _id = DEF_ID, portNum outputPort = None, portNum inputPort = None);
 
+    /**
+     * ポート操作ハンドルを取得する
+     *
+     * @param outputPort    使用する出力ポートの番号 Fets::Out1 ~ Fets::Out7
+     * @param inputPort     使用する入力ポートの番号 Fets::In1 ~ Fets::In7 @n
+     *                      指定しなくても良い
+     *
+     * @return  この実体を操作する Fets::Port
+     *
+     * @note    ポートごとに実体化する代わりに使用する
+     */
+    Port port(portNum outputPort, portNum inputPort = None);
+
 
     /**
      * 出力
@@ -131,6 +318,8 @@ public:
      *
      * @retval -1   出力ポート指定が不正
      * @retval -2   出力値指定が不正
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
      * @retval 0    正常
      */
     int write(int duty, portNum outputPort = None);
@@ -147,14 +336,38 @@ public:
      * @retval -2   出力ポート指定が不正 PWM出力不可
      * @retval -3   出力値指定が不正 @p 0.0 未満
      * @retval -4   出力値指定が不正 @p 1.0 超過
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
      * @retval 0    正常
      * 
      * @remarks Fets::Out7 はPWM出力ができない
+     * @note    出力値は7bitに切り捨て，常に 4byte のフレームで送る @n
+     *          細かい出力値が必要な場合は writeDuty() を使う
      *
      * @overload
      */
     int write(double duty, portNum outputPort = None);
 
+    /**
+     * 出力
+     *
+     * 12bitの出力値でPWM出力を行う
+     * @param duty          出力値 @p 0 ~ @p MAX_DUTY
+     * @param outputPort    出力ポートの番号 Fets::Out1 ~ Fets::Out6 @n
+     *                      クラスをポート指定で実体化した場合必要ない
+     *
+     * @retval -1   出力ポート指定が不正
+     * @retval -2   出力ポート指定が不正 PWM出力不可
+     * @retval -3   出力値指定が不正 @p MAX_DUTY 超過
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
+     * @retval 0    正常
+     *
+     * @note    7bitで表せる値であれば 4byte のフレーム，表せなければ 6byte の拡張フレームで送る
+     * @attention 拡張フレームに対応したモジュールでのみ使用できる
+     */
+    int writeDuty(uint16_t duty, portNum outputPort = None);
+
     /**
      * センサ応答を設定する
      *
@@ -173,6 +386,8 @@ public:
      * @retval -2   入力ポート指定が不正
      * @retval 1    動作完了： actOutput で指定された出力をしている @n
      *              ただし recvData() または getOutputState() または getInputState() が実行されていなければ動作完了は返さない
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
      * @retval 0    正常
      */
     int sensorResponce(uint8_t actInput, uint8_t actOutput, portNum outputPort = None, portNum inputPort = None);
@@ -195,6 +410,8 @@ public:
      * @retval -2   入力ポート指定が不正
      * @retval 1    動作完了： actOutput で指定された出力をしている @n
      *              ただし recvData() または getOutputState() または getInputState() が実行されていなければ動作完了は返さない
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
      * @retval 0    正常
      *
      * @note    この機能では出力の初期化を行わない
@@ -215,10 +432,132 @@ public:
      * @retval -2   出力ポート指定が不正 PWM出力不可
      * @retval -3   周期指定が不正 @p 100 未満
      * @retval -4   周期指定が不正 @p 10000 超過
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
      * @retval 0    正常
+     *
+     * @note    周期は100[ms]単位に切り捨て，常に 4byte のフレームで送る @n
+     *          細かい周期が必要な場合は writeWaveFine() を使う
      */
     int writeWave(waveform form, int period, portNum outputPort = None);
 
+    /**
+     * 出力
+     *
+     * 1[ms]単位の周期で特定の波形を出力する
+     * @param form          波形を指定する @p enum
+     * @param period        周期[ms] @p 100 ~ @p 10000
+     * @param outputPort    出力ポートの番号 Fets::Out1 ~ Fets::Out6 @n
+     *                      クラスをポート指定で実体化した場合必要ない
+     *
+     * @retval -1   出力ポート指定が不正
+     * @retval -2   出力ポート指定が不正 PWM出力不可
+     * @retval -3   周期指定が不正 @p 100 未満
+     * @retval -4   周期指定が不正 @p 10000 超過
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
+     * @retval 0    正常
+     *
+     * @note    周期が100[ms]単位であれば 4byte のフレーム，そうでなければ 6byte の拡張フレームで送る
+     * @attention 拡張フレームに対応したモジュールでのみ使用できる
+     */
+    int writeWaveFine(waveform form, int period, portNum outputPort = None);
+
+    /**
+     * 出力パターンを登録する
+     *
+     * (出力値, 長さ) の区間の並びをモジュールに送って登録する @n
+     * 登録したパターンは startPattern() の1フレームで開始でき，以降はモジュールが出力し続ける @n
+     * PWM出力を毎周期送るかわりに使用すると通信量を減らせる
+     *
+     * @param seg           区間の配列
+     * @param num           区間の数 @p 1 ~ @p PATTERN_MAX_SEG
+     * @param outputPort    出力ポートの番号 Fets::Out1 ~ Fets::Out6 @n
+     *                      クラスをポート指定で実体化した場合必要ない
+     *
+     * @retval -1   出力ポート指定が不正
+     * @retval -2   出力ポート指定が不正 PWM出力不可
+     * @retval -3   区間の数が不正
+     * @retval -4   出力値指定が不正 @p 0.0 未満 または @p 1.0 超過
+     * @retval -5   区間の長さ指定が不正 @p 10 未満 または @p 1270 超過
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
+     * @retval 0    正常
+     *
+     * @note    登録の前にそのポートのパターンは停止，消去される
+     * @note    区間の長さが前の区間と同じときは長さを送らない @n
+     *          送信は1区間あたり 4byte または 8byte となる
+     */
+    int uploadPattern(const patternSeg *seg, int num, portNum outputPort = None);
+
+    /**
+     * 出力値の表を出力パターンとして登録する
+     *
+     * すべての区間の長さが同じパターンを登録する
+     *
+     * @param table         出力値の表 @p 0 ~ @p 127 (@p 127 で出力値 @p 1.0 )
+     * @param num           表の要素数 @p 1 ~ @p PATTERN_MAX_SEG
+     * @param time          1区間の長さ[ms] @p 10 ~ @p 1270
+     * @param outputPort    出力ポートの番号 Fets::Out1 ~ Fets::Out6 @n
+     *                      クラスをポート指定で実体化した場合必要ない
+     *
+     * @retval -1   出力ポート指定が不正
+     * @retval -2   出力ポート指定が不正 PWM出力不可
+     * @retval -3   表の要素数が不正
+     * @retval -4   出力値指定が不正 @p 127 超過
+     * @retval -5   区間の長さ指定が不正 @p 10 未満 または @p 1270 超過
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
+     * @retval 0    正常
+     *
+     * @overload
+     */
+    int uploadPattern(const uint8_t *table, int num, int time, portNum outputPort = None);
+
+    /**
+     * 登録した出力パターンを開始する
+     *
+     * @param loop          @p true なら繰り返す， @p false なら1回で終了し最後の区間の出力を保つ
+     * @param phase         開始する区間の番号 @p 0 ~ @p PATTERN_MAX_SEG-1 @n
+     *                      同じパターンを複数のポートでずらして出力するときに使う
+     * @param outputPort    出力ポートの番号 Fets::Out1 ~ Fets::Out6 @n
+     *                      クラスをポート指定で実体化した場合必要ない
+     *
+     * @retval -1   出力ポート指定が不正
+     * @retval -2   出力ポート指定が不正 PWM出力不可
+     * @retval -3   開始区間指定が不正
+     * @retval FET_ERR_LOCKED   LinkMonitor が途絶を検出して出力を止めている
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
+     * @retval 0    正常
+     */
+    int startPattern(bool loop = true, int phase = 0, portNum outputPort = None);
+
+    /**
+     * 出力パターンを停止し，登録したパターンを消去する
+     *
+     * @param outputPort    出力ポートの番号 Fets::Out1 ~ Fets::Out6 @n
+     *                      クラスをポート指定で実体化した場合必要ない
+     *
+     * @retval -1   出力ポート指定が不正
+     * @retval -2   出力ポート指定が不正 PWM出力不可
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかった
+     * @retval 0    正常
+     */
+    int stopPattern(portNum outputPort = None);
+
+    /**
+     * すべての出力ポートのパターンを停止し，出力を切る @n
+     * 通信の途絶時などに LinkMonitor が使用する
+     *
+     * @retval -1   IDのモード指定が競合している
+     * @retval FET_ERR_DROPPED  待ち行列が満杯などで送れなかったフレームがある 送れるフレームはすべて送る
+     * @retval 0    正常
+     *
+     * @note    クラスをポート指定で実体化していても，モジュールのすべての出力ポートが対象になる
+     * @note    13 フレーム(52byte)を送信する
+     */
+    int allOff();
+
 
     /**
      * 出力状態を取得する
@@ -257,6 +596,215 @@ public:
      */
     int recvData();
 
+    /**
+     * 入力ポートの変化を監視する
+     *
+     * 監視している入力ポートが変化した状態通知を受信すると，
+     * onInputChange() で設定した関数を呼び出し， takeInputEvents() で得られるフラグを立てる
+     *
+     * 例)
+     * @code
+     *  S_Fets Module_S(&Serial1);
+     *
+     *  void limitHit(uint8_t changed, uint8_t state, unsigned long time){
+     *      // 割り込みではなく recvData() の中から呼ばれる
+     *  }
+     *
+     *  void setup(){
+     *      Module_S.watchInput(Fets::In3, EDGE_RISE);
+     *      Module_S.onInputChange(limitHit);
+     *  }
+     *
+     *  void loop(){
+     *      Module_S.recvData();    // 1周期に1回受信するだけでよい
+     *  }
+     * @endcode
+     *
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     * @param edge          通知する変化 EDGE_RISE , EDGE_FALL , EDGE_BOTH
+     *
+     * @retval -1   入力ポート指定が不正
+     * @retval 0    正常
+     *
+     * @note    最初の状態通知では変化とみなさない
+     */
+    int watchInput(portNum inputPort, uint8_t edge = EDGE_BOTH);
+
+    /**
+     * 入力ポートの監視をやめる
+     *
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     *
+     * @retval -1   入力ポート指定が不正
+     * @retval 0    正常
+     */
+    int unwatchInput(portNum inputPort);
+
+    /**
+     * 入力変化を通知する関数を設定する
+     *
+     * @param func  通知を受ける関数 @n
+     *              NULL を指定すると通知しない
+     *
+     * @attention 関数は recvData() の中から呼ばれるので，中で重い処理をしないこと
+     */
+    void onInputChange(inputHandler func);
+
+    /**
+     * 前回の呼び出し以降に変化した入力ポートを取得し，フラグを消す
+     *
+     * @param time  最後に変化を受信した時刻 micros() [us] の格納先 @n
+     *              必要なければ指定しなくて良い
+     *
+     * @return  変化した入力ポート 右から入力ポート1
+     *
+     * @note    この関数は recvData() を実行しない
+     */
+    uint8_t takeInputEvents(unsigned long *time = NULL);
+
+    /**
+     * 状態の履歴を記録する FetHistory を設定する
+     *
+     * 設定すると recvData() で受信した正しい状態通知をすべて記録する
+     *
+     * @param _history  記録先 @n
+     *                  NULL を指定すると記録しない
+     */
+    void attachHistory(FetHistory *_history);
+
+    /**
+     * 通信を記録する BusRecorder を設定する
+     *
+     * 設定すると送信したフレームと recvData() で受信したデータをすべて記録する
+     *
+     * @note    T_Fets , T_UnderBody では受信データは Transport::attachRecorder() で記録する
+     *
+     * @param _recorder 記録先 @n
+     *                  NULL を指定すると記録しない
+     */
+    void attachRecorder(BusRecorder *_recorder);
+
+    /**
+     * 通信を監視する LinkMonitor を設定する
+     *
+     * 設定すると recvData() で受信した状態通知を，正しければ LinkMonitor::frameOk() ，
+     * IDが一致してチェックサムが不正なら LinkMonitor::frameError() で報告する
+     *
+     * @param _monitor  報告先 @n
+     *                  NULL を指定すると報告しない
+     */
+    void attachMonitor(LinkMonitor *_monitor);
+
+    /**
+     * 出力を止める状態を設定する
+     *
+     * 止めている間は出力を切る指令( write() の @p 0 , stopPattern() , allOff() )だけを送り，
+     * ほかの出力の指令は送らずに FET_ERR_LOCKED を返す @n
+     * LinkMonitor が途絶を検出したときに設定し，復帰したときに解除する
+     *
+     * @param lock  @p true なら止める
+     */
+    void setFailsafe(bool lock);
+
+    /**
+     * @retval true     出力を止めている
+     * @retval false    通常
+     */
+    bool isFailsafe();
+
+
+    /**
+     * 送信フレーム(4byte)を作成する @n
+     * sendPort() などが使用する
+     *
+     * @param frame         フレームの格納先 4byte以上
+     * @param funcBit       機能指定ビット
+     * @param outputPort    出力ポートの番号
+     * @param parameter     送信パラメータ
+     * @param _id           モジュールのID
+     *
+     * @return  フレームの長さ
+     */
+    static int makeFrame(uint8_t *frame, uint8_t funcBit, portNum outputPort, uint8_t parameter, char _id);
+
+    /**
+     * センサ応答，センサトリガーの送信パラメータを作成する
+     *
+     * @param actInput      動作する入力値
+     * @param actOutput     動作時の出力値
+     * @param inputPort     入力ポートの番号 Fets::In1 ~ Fets::In7
+     *
+     * @return  送信パラメータ
+     */
+    static uint8_t sensorParam(uint8_t actInput, uint8_t actOutput, portNum inputPort);
+
+    /**
+     * 受信フレーム(4byte)が指定IDの状態通知として正しいか確認する
+     *
+     * @param frame     受信フレーム 古い順
+     * @param _id       モジュールのID
+     *
+     * @retval true     正しい状態通知 frame[0] が入力状態， frame[1] が出力状態
+     * @retval false    不正
+     */
+    static bool isStateFrame(const uint8_t *frame, char _id);
+
+    /**
+     * 拡張フレーム(6byte)を作成する @n
+     * 送信パラメータを14bitまで送れる
+     *
+     * @param frame         フレームの格納先 6byte以上
+     * @param funcBit       機能指定ビット
+     * @param outputPort    出力ポートの番号
+     * @param parameter     送信パラメータ @p 0 ~ @p 0x3FFF
+     * @param _id           モジュールのID
+     *
+     * @return  フレームの長さ
+     */
+    static int makeFrameEx(uint8_t *frame, uint8_t funcBit, portNum outputPort, uint16_t parameter, char _id);
+
+    /**
+     * 12bitのPWM出力値が 4byte のフレームで送れるか確認する
+     *
+     * @param duty      出力値 @p 0 ~ @p MAX_DUTY
+     * @param parameter 送れる場合の7bitの送信パラメータの格納先
+     *
+     * @retval true     4byte のフレームで送れる
+     * @retval false    拡張フレームが必要
+     */
+    static bool compactDuty(uint16_t duty, uint8_t *parameter);
+
+    /**
+     * 波出力の周期が 4byte のフレームで送れるか確認する
+     *
+     * @param period    周期[ms]
+     * @param parameter 送れる場合の7bitの送信パラメータの格納先
+     *
+     * @retval true     4byte のフレームで送れる
+     * @retval false    拡張フレームが必要
+     */
+    static bool compactPeriod(int period, uint8_t *parameter);
+
+    /**
+     * 送信フレームを解読する makeFrame() , makeFrameEx() の逆変換
+     *
+     * @param frame         フレーム 4byte または 6byte
+     * @param len           frame の長さ
+     * @param funcBit       機能指定ビットの格納先 拡張フレームなら本来の機能指定ビット
+     * @param outputPort    出力ポートの番号の格納先
+     * @param parameter     送信パラメータの格納先
+     * @param _id           モジュールのIDの格納先
+     *
+     * @retval -1   フレームが不正
+     * @retval 4,6  解読したフレームの長さ
+     */
+    static int decodeFrame(const uint8_t *frame, int len, uint8_t *funcBit, portNum *outputPort, uint16_t *parameter, char *_id);
+
+    /**
+     * ポートをコンパイル時に確認した FetPort は sendPort() と入出力状態を直接使う
+     */
+    template <portNum OP, portNum IP> friend class FetPort;
+
 
 protected:
 
@@ -281,6 +829,21 @@ protected:
      */
     virtual int recieve() = 0;
 
+    /**
+     * フレームをまとめて送信する関数 @n
+     * 呼び出しはメンバ関数が行う
+     *
+     * 標準では send() を1byteずつ呼び出す @n
+     * 拡張クラスでオーバーライドすると，まとめて書き込んだり待ち行列に積んだりできる
+     *
+     * @param frame 送信するフレーム
+     * @param len   フレームの長さ
+     *
+     * @retval true     送信した，または待ち行列に積んだ
+     * @retval false    待ち行列が満杯などで捨てた
+     */
+    virtual bool sendFrame(const uint8_t *frame, int len);
+
     /**
      * 送信用データを作成し send() に送る @n
      * メンバ以外で呼び出しはしない
@@ -288,11 +851,41 @@ protected:
      * @param funcBit       機能指定ビット
      * @param outputPort    出力ポートの番号
      * @param parameter     送信パラメータ
+     * @param extended      @p true なら拡張フレームで送る
      *
      * @retval  0 正常
      * @retval  -1 ポート指定が不正
+     * @retval  FET_ERR_LOCKED 出力を止めている
+     * @retval  FET_ERR_DROPPED sendFrame() がフレームを捨てた
      */
-    int sendData(uint8_t funcBit, portNum outputPort, uint8_t parameter);
+    int sendData(uint8_t funcBit, portNum outputPort, uint16_t parameter, bool extended = false);
+
+    /**
+     * 確認済みの出力ポートで送信用データを作成し sendFrame() に送る @n
+     * sendData() と FetPort が呼び出す
+     *
+     * 出力の停止，待ち行列，記録は sendData() と同じように働く
+     *
+     * @param funcBit       機能指定ビット
+     * @param outputPort    出力ポートの番号 Fets::Out1 ~ Fets::Out7 であること
+     * @param parameter     送信パラメータ
+     * @param extended      @p true なら拡張フレームで送る
+     *
+     * @retval  0 正常
+     * @retval  FET_ERR_LOCKED 出力を止めている
+     * @retval  FET_ERR_DROPPED sendFrame() がフレームを捨てた
+     */
+    int sendPort(uint8_t funcBit, portNum outputPort, uint16_t parameter, bool extended = false);
+
+    /**
+     * 受信データを1byte解析し，正しい状態通知がそろえばメンバ変数に格納する @n
+     * recvData() が recieve() で読んだ1byteごとに呼び出す
+     *
+     * 受信を Transport などで別に行う拡張クラスは，受信した1byteごとにこの関数を呼び出す
+     *
+     * @param data  受信したデータ
+     */
+    void parseByte(uint8_t data);
 
 private:
 
@@ -316,6 +909,14 @@ private:
      */
     portNum ipCheck(portNum inputPort);
 
+    /**
+     * 正しい状態通知を受信したときに入出力状態を更新し，入力変化を通知する
+     *
+     * @param input     入力状態
+     * @param output    出力状態
+     */
+    void updateState(uint8_t input, uint8_t output);
+
     /**
      * クラスをポート指定で実体化したときの出力番号
      */
@@ -330,16 +931,98 @@ private:
     uint8_t inputState;
     uint8_t outputState;
 
+    /**
+     * 状態通知を1度でも受信したか
+     */
+    bool stateValid;
+
+    /**
+     * LOW から HIGH を監視する入力ポート
+     */
+    uint8_t riseMask;
+
+    /**
+     * HIGH から LOW を監視する入力ポート
+     */
+    uint8_t fallMask;
+
+    /**
+     * takeInputEvents() で取得されていない入力変化
+     */
+    uint8_t inputEvents;
+
+    /**
+     * 最後に入力変化を受信した時刻[us]
+     */
+    unsigned long eventTime;
+
+    /**
+     * 入力変化を通知する関数
+     */
+    inputHandler handler;
+
+    /**
+     * 状態の履歴の記録先
+     */
+    FetHistory *history;
+
+    /**
+     * 通信の記録先
+     */
+    BusRecorder *recorder;
+
+    /**
+     * 通信の監視先
+     */
+    LinkMonitor *monitor;
+
+    /**
+     * 出力を止めている
+     */
+    bool failsafe;
+
     /**
      * 受信情報の配列
      */
-    char dataBuff[4];
+    uint8_t dataBuff[4];
+
+    /**
+     * IDに対応するモードの格納場所を返す @n
+     * 未登録のIDであれば新しく登録する
+     *
+     * @param _id   モジュールのID
+     *
+     * @return  モードの格納場所 @n
+     *          登録数が MODE_TABLE_SIZE を超える場合は modeConflict を返す
+     */
+    static char *modeOf(char _id);
+
+    /**
+     * クラスがモジュールとして実体化されたか，ピン指定で実体化されたかの状態の格納場所 @n
+     * 同じIDの実体で統一させるため，IDごとの静的メンバ変数 modeTable を指す
+     */
+    char *mode;
+
+    /**
+     * モードを記録したモジュールのID
+     */
+    static char modeId[MODE_TABLE_SIZE];
+
+    /**
+     * IDごとのモード
+     */
+    static char modeTable[MODE_TABLE_SIZE];
+
+    /**
+     * modeTable に登録したIDの数
+     */
+    static uint8_t modeNum;
 
     /**
-     * クラスがモジュールとして実体化されたか，ピン指定で実体化されたかの状態を格納 @n
-     * 複数のクラスで統一させるため，静的メンバ変数とする
+     * modeTable に登録できなかった実体のモード @n
+     * 常に MODE_CONFLICT である
      */
-    static char mode;
+    static char modeConflict;
 
     /**
      * スレーブモジュールのID
@@ -0,0 +1,107 @@
+/**
+ * @file FrameQueue.cpp
+ * @brief FrameQueue , FrameQueueMP クラスメンバの実装
+ */
+
+#include "FrameQueue.h"
+#include "InterruptLock.h"
+#include "Transport.h"
+
+
+FrameQueue::FrameQueue(){
+    head = 0;
+    tail = 0;
+    dropped = 0;
+}
+
+bool FrameQueue::push(const uint8_t *frame, int len){
+    return commit(frame, len);
+}
+
+int FrameQueue::pop(uint8_t *frame){
+    uint8_t index = tail;
+    int len;
+
+    if(index == head) return 0;
+
+    len = frameLen[index];
+    for(int i=0; i<len; i++){
+        frame[i] = frames[index][i];
+    }
+
+    tail = (index + 1) % FRAME_QUEUE_SIZE;     // 読み終えてから位置を進める
+
+    return len;
+}
+
+int FrameQueue::drain(Print *out, int maxFrame){
+    uint8_t frame[FRAME_MAX_LEN];
+    int len;
+    int num = 0;
+
+    while(num < maxFrame && (len = pop(frame)) > 0){
+        out->write(frame, len);
+        num++;
+    }
+
+    return num;
+}
+
+int FrameQueue::drain(Transport *link, int maxFrame){
+    uint8_t frame[FRAME_MAX_LEN];
+    int len;
+    int num = 0;
+    int sent = 0;
+
+    while(num < maxFrame && (len = pop(frame)) > 0){
+        if(link->sendFrame(frame, len)) sent++;
+        num++;
+    }
+
+    return sent;
+}
+
+int FrameQueue::count(){
+    return (head + FRAME_QUEUE_SIZE - tail) % FRAME_QUEUE_SIZE;
+}
+
+unsigned int FrameQueue::getDropped(){
+    return dropped;
+}
+
+bool FrameQueue::commit(const uint8_t *frame, int len){
+    uint8_t index = head;
+    uint8_t next = (index + 1) % FRAME_QUEUE_SIZE;
+
+    if(len < 1 || len > FRAME_MAX_LEN) return false;
+
+    if(next == tail){
+        dropped++;
+        return false;
+    }
+
+    frameLen[index] = len;
+    for(int i=0; i<len; i++){
+        frames[index][i] = frame[i];
+    }
+
+    head = next;    // 書き終えてから公開する
+
+    return true;
+}
+
+
+
+bool FrameQueueMP::push(const uint8_t *frame, int len){
+    bool result;
+
+    unsigned long state = lockInterrupts();
+    result = commit(frame, len);
+    unlockInterrupts(state);
+
+    return result;
+}
+
+bool FrameQueueMP::pushFromISR(const uint8_t *frame, int len){
+    return commit(frame, len);
+}
\ No newline at end of file
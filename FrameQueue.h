@@ -0,0 +1,208 @@
+/**
+ * @file FrameQueue.h
+ * @brief 割り込みとメインループから送信フレームを積むための待ち行列
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/18
+ */
+
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <Arduino.h>
+
+#define FRAME_QUEUE_SIZE 16     /**< 待ち行列の段数 格納できるフレーム数は1少ない */
+#define FRAME_MAX_LEN 8         /**< 1フレームの最大長[byte] */
+
+class Transport;
+
+
+/**
+ * @brief 送信フレームの待ち行列 (単一生産者/単一消費者)
+ *
+ *
+ * モジュールに送るフレームを丸ごと積み，所有者がまとめてシリアル通信や Transport に書き出す @n
+ * 積む側( push() )と取り出す側( pop() , drain() )がそれぞれ1つであれば，
+ * 割り込み禁止なしで割り込みとメインループの間で安全に受け渡せる
+ *
+ * 例) タイマ割り込みで積み， loop() で送信する
+ * @code
+ *  FrameQueue IsrQueue;
+ *  S_Fets SafetyFet(&Serial1);
+ *
+ *  void setup(){
+ *      SafetyFet.setQueue(&IsrQueue);
+ *  }
+ *
+ *  void timerHandler(){        // 割り込み
+ *      SafetyFet.write(0, Fets::Out1);
+ *  }
+ *
+ *  void loop(){
+ *      IsrQueue.drain(&Serial1);
+ *  }
+ * @endcode
+ *
+ * @note    フレームは途中で分断されないので，複数の送信元のフレームが混ざることはない
+ * @note    満杯のときに積んだフレームは捨てられ， getDropped() で数を確認できる @n
+ *          Fets , UnderBody のメソッドは FET_ERR_DROPPED , MOVE_ERR_DROPPED を返す
+ */
+class FrameQueue
+{
+public:
+
+    /**
+     * コンストラクタ
+     */
+    FrameQueue();
+
+    /**
+     * フレームを積む
+     *
+     * @param frame     フレーム
+     * @param len       フレームの長さ @p 1 ~ @p FRAME_MAX_LEN
+     *
+     * @retval true     正常
+     * @retval false    満杯，またはフレーム長が不正 フレームは捨てられる
+     *
+     * @attention 積む側が複数ある場合は FrameQueueMP を使用すること
+     */
+    virtual bool push(const uint8_t *frame, int len);
+
+    /**
+     * フレームを1つ取り出す
+     *
+     * @param frame     フレームの格納先 @p FRAME_MAX_LEN byte以上
+     *
+     * @retval 0                フレームなし
+     * @retval 1~FRAME_MAX_LEN  取り出したフレームの長さ
+     */
+    int pop(uint8_t *frame);
+
+    /**
+     * 積まれているフレームをすべて書き出す
+     *
+     * @param out       書き出し先 &Serial1 など
+     * @param maxFrame  書き出す最大のフレーム数
+     *
+     * @return  書き出したフレーム数
+     */
+    int drain(Print *out, int maxFrame = FRAME_QUEUE_SIZE);
+
+    /**
+     * 積まれているフレームをすべて通信路に送る @n
+     * T_Fets::setQueue() , T_UnderBody::setQueue() で設定した待ち行列を送るときに使う
+     *
+     * @param link      送信先の通信路
+     * @param maxFrame  送る最大のフレーム数
+     *
+     * @return  通信路が受け付けたフレーム数 @n
+     *          Transport::sendFrame() が捨てたフレームは数えず，待ち行列にも戻さない
+     */
+    int drain(Transport *link, int maxFrame = FRAME_QUEUE_SIZE);
+
+    /**
+     * @return 積まれているフレーム数
+     */
+    int count();
+
+    /**
+     * @return 満杯で捨てたフレーム数
+     */
+    unsigned int getDropped();
+
+protected:
+
+    /**
+     * 割り込み禁止などの排他をせずにフレームを積む
+     *
+     * @param frame     フレーム
+     * @param len       フレームの長さ
+     *
+     * @retval true     正常
+     * @retval false    満杯，またはフレーム長が不正
+     */
+    bool commit(const uint8_t *frame, int len);
+
+private:
+
+    /**
+     * フレームの長さ
+     */
+    volatile uint8_t frameLen[FRAME_QUEUE_SIZE];
+
+    /**
+     * フレームの格納先
+     */
+    volatile uint8_t frames[FRAME_QUEUE_SIZE][FRAME_MAX_LEN];
+
+    /**
+     * 次に積む位置 積む側だけが書き換える
+     */
+    volatile uint8_t head;
+
+    /**
+     * 次に取り出す位置 取り出す側だけが書き換える
+     */
+    volatile uint8_t tail;
+
+    /**
+     * 捨てたフレーム数
+     */
+    volatile unsigned int dropped;
+};
+
+
+/**
+ * @brief 送信フレームの待ち行列 (複数生産者/単一消費者)
+ *
+ *
+ * FrameQueue を複数の送信元から使うための派生クラス @n
+ * push() はフレームを書き込む間だけ割り込みを禁止し，その後は禁止する前の状態に戻す @n
+ * そのため1つの待ち行列を S_Fets などに設定し，割り込みと loop() の両方から使える
+ *
+ * 例) 割り込みとメインループで同じモジュールに送る
+ * @code
+ *  FrameQueueMP TxQueue;
+ *  S_Fets SafetyFet(&Serial1);
+ *
+ *  void setup(){
+ *      SafetyFet.setQueue(&TxQueue);
+ *  }
+ *
+ *  void timerHandler(){        // 割り込み
+ *      SafetyFet.write(0, Fets::Out1);
+ *  }
+ *
+ *  void loop(){
+ *      SafetyFet.write(1, Fets::Out2);
+ *      TxQueue.drain(&Serial1);
+ *  }
+ * @endcode
+ *
+ * @note    割り込み状態の保存は GR-SAKURA (RX) と AVR で行う (InterruptLock.h) @n
+ *          それ以外の環境では push() は割り込みを許可して戻るので，割り込みの中では pushFromISR() を使うこと
+ * @note    送信の記録( BusRecorder )も同じく割り込みを禁止して行うので，割り込みから送信する実体に設定してもよい
+ */
+class FrameQueueMP : public FrameQueue
+{
+public:
+
+    /**
+     * フレームを積む @n
+     * 書き込みの間だけ割り込みを禁止し，禁止する前の状態に戻す @n
+     * メインループと割り込みのどちらからでも呼び出せる
+     *
+     * @see FrameQueue::push()
+     */
+    bool push(const uint8_t *frame, int len); //override
+
+    /**
+     * 割り込みの中からフレームを積む @n
+     * 割り込み禁止の操作をしないので push() より速い
+     *
+     * @see FrameQueue::push()
+     */
+    bool pushFromISR(const uint8_t *frame, int len);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+/**
+ * @file InterruptLock.h
+ * @brief 割り込み禁止の前の状態を保存して禁止し，元の状態に戻す
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ *
+ * FrameQueueMP , BusRecorder が割り込みとメインループの両方から呼ばれる処理を守るために使う @n
+ * lockInterrupts() の戻り値を unlockInterrupts() に与えると，割り込みの中で呼ばれても割り込みを許可しない
+ *
+ * 例)
+ * @code
+ *  unsigned long state = lockInterrupts();
+ *  ...     // 割り込みに割り込まれたくない処理
+ *  unlockInterrupts(state);
+ * @endcode
+ */
+
+#ifndef INTERRUPT_LOCK_H
+#define INTERRUPT_LOCK_H
+
+#include <Arduino.h>
+
+#if defined(__RX__)
+
+static inline unsigned long lockInterrupts(){
+    unsigned long psw = __builtin_rx_mvfc(0);     // PSW
+
+    __builtin_rx_clrpsw('I');
+    return psw;
+}
+
+static inline void unlockInterrupts(unsigned long state){
+    if(state & 0x00010000UL) __builtin_rx_setpsw('I');  // Iビットが立っていたときだけ許可する
+}
+
+#elif defined(__AVR__)
+
+static inline unsigned long lockInterrupts(){
+    unsigned long sreg = SREG;
+
+    noInterrupts();
+    return sreg;
+}
+
+static inline void unlockInterrupts(unsigned long state){
+    SREG = (uint8_t)state;
+}
+
+#else
+
+static inline unsigned long lockInterrupts(){   // 状態を読めない環境 割り込みの中では使わないこと
+    noInterrupts();
+    return 1;
+}
+
+static inline void unlockInterrupts(unsigned long state){
+    if(state) interrupts();
+}
+
+#endif
+
+#endif
\ No newline at end of file
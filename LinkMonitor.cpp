@@ -0,0 +1,170 @@
+/**
+ * @file LinkMonitor.cpp
+ * @brief LinkMonitor クラスメンバの実装
+ */
+
+#include "LinkMonitor.h"
+#include "Fets.h"
+#include "UnderBody.h"
+
+
+LinkMonitor::LinkMonitor(){
+    nodeNum = 0;
+    bodyNum = 0;
+    moduleNum = 0;
+    degradeRate = LINK_RATE_ONE / 4;
+    handler = NULL;
+}
+
+int LinkMonitor::watch(uint8_t id, unsigned int timeout, uint8_t action){
+    node *n = find(id);
+
+    if(timeout == 0) return -2;
+
+    if(n == NULL){
+        if(nodeNum >= LINK_MAX_NODE) return -1;
+
+        n = &nodes[nodeNum++];
+        n->id = id;
+        n->state = LINK_UNKNOWN;
+        n->errorRate = 0;
+        n->lastSeen = millis();
+    }
+
+    n->timeout = timeout;
+    n->action = action;
+
+    return 0;
+}
+
+int LinkMonitor::addFailsafe(UnderBody *body){
+    if(bodyNum >= LINK_MAX_TARGET) return -1;
+
+    bodies[bodyNum++] = body;
+    return 0;
+}
+
+int LinkMonitor::addFailsafe(Fets *module){
+    if(moduleNum >= LINK_MAX_TARGET) return -1;
+
+    modules[moduleNum++] = module;
+    return 0;
+}
+
+void LinkMonitor::onStateChange(linkHandler func){
+    handler = func;
+}
+
+void LinkMonitor::setDegradeRate(unsigned int rate){
+    degradeRate = constrain(rate, 1U, (unsigned int)LINK_RATE_ONE);
+}
+
+void LinkMonitor::frameOk(uint8_t id){
+    node *n = find(id);
+
+    if(n == NULL) return;
+
+    n->lastSeen = millis();
+    n->errorRate -= n->errorRate >> LINK_RATE_SHIFT;
+
+    setState(n, (n->errorRate >= degradeRate) ? LINK_DEGRADED : LINK_OK);
+}
+
+void LinkMonitor::frameError(uint8_t id){
+    node *n = find(id);
+
+    if(n == NULL) return;
+
+    n->errorRate += (LINK_RATE_ONE - n->errorRate) >> LINK_RATE_SHIFT;
+
+    if(n->state == LINK_OK && n->errorRate >= degradeRate) setState(n, LINK_DEGRADED);
+}
+
+int LinkMonitor::update(){
+    unsigned long now = millis();
+    int offline = 0;
+
+    for(int i=0; i<nodeNum; i++){
+        node *n = &nodes[i];
+        unsigned long silence = now - n->lastSeen;
+
+        if(silence >= n->timeout){
+            setState(n, LINK_OFFLINE);
+        }
+        else if(n->state == LINK_OK && silence >= n->timeout / 2){
+            setState(n, LINK_DEGRADED);
+        }
+
+        if(n->state == LINK_OFFLINE) offline++;
+    }
+
+    return offline;
+}
+
+int LinkMonitor::getState(uint8_t id){
+    node *n = find(id);
+
+    if(n == NULL) return -1;
+
+    return n->state;
+}
+
+unsigned int LinkMonitor::getErrorRate(uint8_t id){
+    node *n = find(id);
+
+    if(n == NULL) return 0;
+
+    return n->errorRate;
+}
+
+unsigned long LinkMonitor::getSilence(uint8_t id){
+    node *n = find(id);
+
+    if(n == NULL) return 0;
+
+    return millis() - n->lastSeen;
+}
+
+LinkMonitor::node *LinkMonitor::find(uint8_t id){
+
+    for(int i=0; i<nodeNum; i++){
+        if(nodes[i].id == id) return &nodes[i];
+    }
+
+    return NULL;
+}
+
+void LinkMonitor::setState(node *n, uint8_t state){
+    if(n->state == state) return;
+
+    bool wasOffline = (n->state == LINK_OFFLINE);
+
+    n->state = state;
+
+    if(state == LINK_OFFLINE){
+        latch();
+
+        if(n->action & LINK_ACT_STOP){
+            for(int i=0; i<bodyNum; i++) bodies[i]->stop();
+        }
+        if(n->action & LINK_ACT_FET_OFF){
+            for(int i=0; i<moduleNum; i++) modules[i]->allOff();
+        }
+    }
+    else if(wasOffline){
+        latch();
+    }
+
+    if(handler != NULL) handler(n->id, state);
+}
+
+void LinkMonitor::latch(){
+    uint8_t action = 0;
+
+    for(int i=0; i<nodeNum; i++){
+        if(nodes[i].state == LINK_OFFLINE) action |= nodes[i].action;
+    }
+
+    for(int i=0; i<bodyNum; i++) bodies[i]->setFailsafe(action & LINK_ACT_STOP);
+    for(int i=0; i<moduleNum; i++) modules[i]->setFailsafe(action & LINK_ACT_FET_OFF);
+}
@@ -0,0 +1,237 @@
+/**
+ * @file LinkMonitor.h
+ * @brief モジュールとの通信の途絶を検出し，安全側に停止させる監視機能
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <Arduino.h>
+
+class Fets;
+class UnderBody;
+
+#define LINK_MAX_NODE 8         /**< 監視できるモジュールの数 */
+#define LINK_MAX_TARGET 4       /**< 停止させる Fets , UnderBody それぞれの数 */
+
+#define LINK_ID_UNDERBODY 0xFF  /**< 足回りモジュールを監視するときのID */
+
+#define LINK_RATE_ONE 1024      /**< エラー率 100% に相当する値 */
+#define LINK_RATE_SHIFT 3       /**< エラー率の平滑化 1/8 ずつ新しいフレームを反映する */
+
+#define LINK_UNKNOWN 0          /**< 通信状態 まだ受信していない */
+#define LINK_OK 1               /**< 通信状態 正常 */
+#define LINK_DEGRADED 2         /**< 通信状態 エラーが多い，または受信間隔が開いている */
+#define LINK_OFFLINE 3          /**< 通信状態 途絶 */
+
+#define LINK_ACT_STOP 0x01      /**< 途絶時の動作 登録した UnderBody を停止する */
+#define LINK_ACT_FET_OFF 0x02   /**< 途絶時の動作 登録した Fets の出力をすべて切る */
+#define LINK_ACT_ALL 0x03       /**< 途絶時の動作 すべて */
+
+
+/**
+ * 通信状態の変化を通知する関数の型
+ *
+ * @param id        モジュールのID
+ * @param state     新しい通信状態 LINK_OK , LINK_DEGRADED , LINK_OFFLINE
+ */
+typedef void (*linkHandler)(uint8_t id, uint8_t state);
+
+
+/**
+ * @brief 通信の監視クラス
+ *
+ *
+ * モジュールのIDごとに最後に正しいフレームを受信した時刻とエラー率を記録し，
+ * 通信状態を LINK_OK , LINK_DEGRADED , LINK_OFFLINE に分類する @n
+ * 途絶したときは登録した UnderBody を stop() し， Fets の出力を allOff() する @n
+ * 途絶している間は UnderBody::setFailsafe() , Fets::setFailsafe() で停止を保持し，
+ * スケッチが moveXY() や write() を呼んでも移動や出力の指令は送らない (戻り値が MOVE_ERR_LOCKED , FET_ERR_LOCKED になる)
+ *
+ * 受信の報告は Fets::attachMonitor() , UnderBody::attachMonitor() で設定すると recvData() の中で自動で行われる
+ *
+ * 例) 足回りとFETモジュールの途絶を 100[ms] で検出する
+ * @code
+ *  S_UnderBody Omni4(&Serial1);
+ *  S_Fets Module_S(&Serial2);
+ *  LinkMonitor Monitor;
+ *
+ *  void setup(){
+ *      Omni4.attachMonitor(&Monitor);
+ *      Module_S.attachMonitor(&Monitor);
+ *
+ *      Monitor.watch(LINK_ID_UNDERBODY, 100);
+ *      Monitor.watch(DEF_ID, 100, LINK_ACT_FET_OFF);
+ *      Monitor.addFailsafe(&Omni4);
+ *      Monitor.addFailsafe(&Module_S);
+ *  }
+ *
+ *  void loop(){
+ *      Omni4.recvData();
+ *      Module_S.recvData();
+ *      Monitor.update();
+ *  }
+ * @endcode
+ *
+ * @note    途絶は最後の受信から timeout 経過後，次の update() で検出される @n
+ *          検出までの時間は最大で timeout と update() の呼び出し間隔の和である
+ * @note    モジュールが定期的に状態を送信していることが前提である
+ * @note    停止の保持は正しいフレームを受信して LINK_OFFLINE でなくなると解除する @n
+ *          解除しても出力は元に戻さないので，スケッチが改めて指令を送る @n
+ *          復帰を待たずに解除する場合は UnderBody::setFailsafe() , Fets::setFailsafe() に @p false を与える
+ * @note    複数のモジュールが途絶しているときは，途絶しているすべてのモジュールの action の論理和で保持する
+ */
+class LinkMonitor
+{
+public:
+
+    /**
+     * コンストラクタ
+     */
+    LinkMonitor();
+
+    /**
+     * 監視するモジュールを登録する
+     *
+     * 登録した時刻から監視を始めるので，一度も受信しなければ timeout 後に途絶とみなす
+     *
+     * @param id        モジュールのID 足回りモジュールは LINK_ID_UNDERBODY
+     * @param timeout   途絶とみなす受信間隔[ms] 半分を超えると LINK_DEGRADED
+     * @param action    途絶時の動作 LINK_ACT_STOP , LINK_ACT_FET_OFF の論理和
+     *
+     * @retval -1   登録数の上限
+     * @retval -2   timeout が不正
+     * @retval 0    正常 登録済みのIDなら設定を変更する
+     */
+    int watch(uint8_t id, unsigned int timeout, uint8_t action = LINK_ACT_ALL);
+
+    /**
+     * 途絶時に停止させる足回りを登録する
+     *
+     * @param body  停止させる足回り
+     *
+     * @retval -1   登録数の上限
+     * @retval 0    正常
+     */
+    int addFailsafe(UnderBody *body);
+
+    /**
+     * 途絶時に出力を切るFETモジュールを登録する
+     *
+     * @param module    出力を切るFETモジュール
+     *
+     * @retval -1   登録数の上限
+     * @retval 0    正常
+     */
+    int addFailsafe(Fets *module);
+
+    /**
+     * 通信状態の変化を通知する関数を設定する
+     *
+     * @param func  通知を受ける関数 @n
+     *              NULL を指定すると通知しない
+     *
+     * @attention 関数は update() と受信の報告の中から呼ばれるので，中で重い処理をしないこと
+     */
+    void onStateChange(linkHandler func);
+
+    /**
+     * LINK_DEGRADED とみなすエラー率を設定する
+     *
+     * @param rate  エラー率 @p 1 ~ @p LINK_RATE_ONE 初期値は @p LINK_RATE_ONE/4
+     */
+    void setDegradeRate(unsigned int rate);
+
+    /**
+     * 正しいフレームの受信を報告する
+     *
+     * @param id    モジュールのID
+     */
+    void frameOk(uint8_t id);
+
+    /**
+     * 壊れたフレームの受信を報告する
+     *
+     * @param id    モジュールのID
+     */
+    void frameError(uint8_t id);
+
+    /**
+     * 受信間隔を調べて通信状態を更新し，途絶していれば停止させる @n
+     * 制御周期ごとに呼び出す
+     *
+     * @return  途絶しているモジュールの数
+     */
+    int update();
+
+    /**
+     * @param id    モジュールのID
+     *
+     * @retval -1   監視していないID
+     * @retval LINK_UNKNOWN~LINK_OFFLINE    通信状態
+     */
+    int getState(uint8_t id);
+
+    /**
+     * @param id    モジュールのID
+     *
+     * @return  平滑化したエラー率 @p 0 ~ @p LINK_RATE_ONE 監視していないIDなら @p 0
+     */
+    unsigned int getErrorRate(uint8_t id);
+
+    /**
+     * @param id    モジュールのID
+     *
+     * @return  最後に正しいフレームを受信してからの時間[ms] 監視していないIDなら @p 0
+     */
+    unsigned long getSilence(uint8_t id);
+
+private:
+
+    /**
+     * 監視するモジュールの情報
+     */
+    struct node{
+        uint8_t id;
+        uint8_t state;
+        uint8_t action;
+        unsigned int timeout;
+        unsigned int errorRate;
+        unsigned long lastSeen;
+    };
+
+    /**
+     * IDに対応する監視情報を返す
+     *
+     * @retval NULL 監視していないID
+     */
+    node *find(uint8_t id);
+
+    /**
+     * 通信状態を変更し，変化を通知する @n
+     * LINK_OFFLINE になったときは途絶時の動作を行い， LINK_OFFLINE でなくなったときは停止の保持を見直す
+     */
+    void setState(node *n, uint8_t state);
+
+    /**
+     * 途絶しているモジュールに合わせて，登録した UnderBody , Fets の停止の保持を設定する
+     */
+    void latch();
+
+    node nodes[LINK_MAX_NODE];
+    uint8_t nodeNum;
+
+    UnderBody *bodies[LINK_MAX_TARGET];
+    uint8_t bodyNum;
+
+    Fets *modules[LINK_MAX_TARGET];
+    uint8_t moduleNum;
+
+    unsigned int degradeRate;
+
+    linkHandler handler;
+};
+
+#endif
\ No newline at end of file
@@ -9,23 +9,44 @@
 #include <arduino.h>
 
 #include "Sakura_modules.h"
+#include "AnalogSampler.h"
+#include "AxisShaper.h"
 
 #define PIN_CONT_X A0
 #define PIN_CONT_Y A1
 #define PIN_CONT_T A2
 
-#define CONT_SPEED 1.0
-#define CONT_ANG 3.14
+#define CONT_SPEED 500     // 最大速度[mm/s]
+#define CONT_ANG 90         // 最大旋回速度[deg/s]
 
-#define BUFF_SMOOTH 50
+#define CONT_DEADBAND 40    // 不感帯 ADの値
+#define CONT_EXPO 30        // 指数カーブ[%]
+#define CONT_ACC 20         // 1周期での速度変化の上限[mm/s]
+#define CONT_ANG_ACC 4      // 1周期での旋回速度変化の上限[deg/s]
+
+#define SAMPLE_SHIFT 2      // 4回ずつ平均
+#define SAMPLE_PER_LOOP 3   // 1周期でのAD変換の回数
 
 
 S_UnderBody Omni4(&Serial1);
 
+const int contPins[] = {PIN_CONT_X, PIN_CONT_Y, PIN_CONT_T};
+AnalogSampler Sampler(contPins, 3, SAMPLE_SHIFT);
+
+AxisShaper Shaper[3] = {AxisShaper(CONT_SPEED), AxisShaper(CONT_SPEED), AxisShaper(CONT_ANG)};
+
 void setup(){
 
     pinMode(PIN_LED0, OUTPUT);
     analogReference(RAW12BIT);
+    Sampler.sample();
+
+    for(int i=0; i<3; i++){     // 起動時の位置を中心とする
+        Shaper[i].setCenter(Sampler.get(i));
+        Shaper[i].setDeadband(CONT_DEADBAND);
+        Shaper[i].setExpo(CONT_EXPO);
+        Shaper[i].setRateLimit((i < 2) ? CONT_ACC : CONT_ANG_ACC);
+    }
 
     digitalWrite(PIN_LED0, HIGH);
     Omni4.begin(115200);
@@ -33,24 +54,16 @@ void setup(){
 
 void loop(){
 
-    static double vX[BUFF_SMOOTH + 1] = {}, vY[BUFF_SMOOTH + 1] = {}, omega[BUFF_SMOOTH + 1] = {};
-    double sumVX = 0, sumVY = 0, sumOmega = 0;
-
-    vX[0] = ((double)analogRead(PIN_CONT_X) - 2048.0)*CONT_SPEED / 4096.0;
-    vY[0] = ((double)analogRead(PIN_CONT_Y) - 2048.0)*CONT_SPEED / 4096.0;
-    omega[0] = ((double)analogRead(PIN_CONT_T) - 2048.0)*CONT_ANG / 4096.0;
+    AnalogSampler::snapshot cont;
 
-    for(int i=BUFF_SMOOTH; i>0; i--){
-        vX[i] = vX[i-1];
-        vY[i] = vY[i-1];
-        omega[i] = omega[i-1];
+    Sampler.poll(SAMPLE_PER_LOOP);
+    Sampler.read(&cont);
 
-        sumVX += vX[i];
-        sumVY += vY[i];
-        sumOmega += omega[i];
+    for(int i=0; i<3; i++){
+        Shaper[i].update(cont.value[i]);
     }
 
-    Omni4.moveXY(sumVX/(double)BUFF_SMOOTH, sumVY/(double)BUFF_SMOOTH, sumOmega/ (double)BUFF_SMOOTH);
+    Omni4.moveXY(Shaper[0].get(), Shaper[1].get(), Shaper[2].get());
 
     delay(10);
 }
\ No newline at end of file
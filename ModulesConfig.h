@@ -0,0 +1,16 @@
+/**
+ * @file ModulesConfig.h
+ * @brief 使用するモジュールライブラリの選択
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ *
+ * Sakura_modules.h と Transport.h が同じ設定を使うように，ここで1か所にまとめて選択する
+ */
+
+#ifndef MODULES_CONFIG_H
+#define MODULES_CONFIG_H
+
+#define USE_FET 1       /**< FETモジュールライブラリの使用の有無を選択する． 使用時は1，不使用時は0にする． */
+#define USE_UNDERBODY 1 /**< UnderBodyモジュールライブラリの使用の有無を選択する． 使用時は1，不使用時は0にする */
+
+#endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+/**
+ * @file PoseController.cpp
+ * @brief PoseController クラスメンバの実装
+ */
+
+#include "PoseController.h"
+#include "FastTrig.h"
+
+
+PoseController::PoseController(UnderBody *_body, unsigned int _period){
+    body = _body;
+    period = _period;
+    lastTime = millis();
+
+    kpXY = 2 * POSE_GAIN_ONE;
+    kdXY = 0;
+    kpTheta = 3 * POSE_GAIN_ONE;
+
+    maxVelo = 1000;
+    maxOmega = 180;
+
+    targetX = 0;
+    targetY = 0;
+    targetTheta = 0;
+
+    poseX = 0;
+    poseY = 0;
+    poseTheta = 0;
+    poseValid = false;
+    poseTime = 0;
+    timeout = POSE_TIMEOUT;
+
+    odometry = false;
+    prevValid = false;
+}
+
+void PoseController::setGain(int _kpXY, int _kdXY, int _kpTheta){
+    kpXY = _kpXY;
+    kdXY = _kdXY;
+    kpTheta = _kpTheta;
+}
+
+void PoseController::setLimit(int _maxVelo, int _maxOmega){
+    maxVelo  = constrain(_maxVelo, 0, MAX_VELO);
+    maxOmega = constrain(_maxOmega, 0, MAX_OMEGA);
+}
+
+void PoseController::setTarget(long x, long y, int theta){
+    targetX = x;
+    targetY = y;
+    targetTheta = theta % 3600;     // 偏差の計算と符号反転があふれないように丸める
+    prevValid = false;
+}
+
+void PoseController::setPose(long x, long y, int theta){
+    poseX = x;
+    poseY = y;
+    poseTheta = theta % 3600;
+    poseValid = true;
+    poseTime = micros();
+}
+
+void PoseController::useOdometry(bool use){
+    odometry = use;
+}
+
+void PoseController::setTimeout(unsigned int ms){
+    timeout = ms;
+}
+
+int PoseController::update(){
+    unsigned long now = millis();
+
+    if(now - lastTime < period) return 0;
+
+    lastTime += period;
+    if(now - lastTime >= period) lastTime = now;    // 大きく遅れた場合は追いつこうとしない
+
+    if(!readPose()){        // 古い位置で制御すると前の速度で走り続けるので止める
+        body->stop();
+        prevValid = false;
+        return -1;
+    }
+
+    long errX = targetX - poseX;
+    long errY = targetY - poseY;
+    int errTheta = (targetTheta - poseTheta) % 3600;
+
+    if(errTheta >= 1800)  errTheta -= 3600;
+    if(errTheta < -1800)  errTheta += 3600;
+
+    // フィールド座標系での速度 [mm/s]
+    long vX = kpXY * errX / POSE_GAIN_ONE;
+    long vY = kpXY * errY / POSE_GAIN_ONE;
+
+    if(prevValid){
+        vX += kdXY * ((errX - prevErrX) * 1000L / (long)period) / POSE_GAIN_ONE;
+        vY += kdXY * ((errY - prevErrY) * 1000L / (long)period) / POSE_GAIN_ONE;
+    }
+    prevErrX = errX;
+    prevErrY = errY;
+    prevValid = true;
+
+    // 向きを保って上限に収める
+    long peak = max(labs(vX), labs(vY));
+    if(peak > maxVelo){
+        vX = vX * maxVelo / peak;
+        vY = vY * maxVelo / peak;
+    }
+
+    long omega = (long)kpTheta * errTheta / (POSE_GAIN_ONE * 10L);
+    omega = constrain(omega, -maxOmega, maxOmega);
+
+    // ロボット座標系に回転する
+    long bodyX, bodyY;
+    FastTrig::rotate(vX, vY, -poseTheta, &bodyX, &bodyY);
+
+    body->moveXY((int)bodyX, (int)bodyY, (int)omega);
+
+    return 1;
+}
+
+bool PoseController::reached(int tolXY, int tolTheta){
+    if(!readPose()) return false;
+
+    int errTheta = (targetTheta - poseTheta) % 3600;
+
+    if(errTheta >= 1800)  errTheta -= 3600;
+    if(errTheta < -1800)  errTheta += 3600;
+
+    return labs(targetX - poseX) <= tolXY
+        && labs(targetY - poseY) <= tolXY
+        && abs(errTheta) <= tolTheta;
+}
+
+bool PoseController::readPose(){
+    if(odometry){
+        const UnderBody::odometry &odom = body->getOdometry();
+
+        if(!(odom.valid & ODOM_VALID_POSE)) return false;
+
+        poseX = odom.x;
+        poseY = odom.y;
+        poseTheta = odom.theta;
+        poseValid = true;
+        poseTime = odom.poseTime;
+    }
+
+    if(!poseValid) return false;
+
+    return timeout == 0 || micros() - poseTime < timeout * 1000UL;
+}
\ No newline at end of file
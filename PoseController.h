@@ -0,0 +1,194 @@
+/**
+ * @file PoseController.h
+ * @brief 足回りモジュールの位置・姿勢制御
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef POSE_CONTROLLER_H
+#define POSE_CONTROLLER_H
+
+#include <Arduino.h>
+
+#include "UnderBody.h"
+
+#define POSE_CTRL_PERIOD 10     /**< 標準の制御周期[ms] */
+#define POSE_GAIN_ONE 256       /**< ゲインの 1.0 に相当する値 */
+#define POSE_TIMEOUT 100        /**< 標準の位置・姿勢の有効時間[ms] */
+
+
+/**
+ * @brief 足回りモジュールの位置・姿勢制御クラス
+ *
+ *
+ * フィールド座標系での目標位置・姿勢と現在の位置・姿勢から，
+ * ロボット座標系での移動速度を計算して UnderBody に一定周期で送る @n
+ * 位置はPD制御，姿勢はP制御(ヘディング保持)である
+ *
+ * 計算はすべて整数で行い，座標変換には FastTrig を使う
+ *
+ * 単位
+ *  - 位置 [mm]
+ *  - 姿勢 [0.1deg] 反時計回りが正 UnderBody::odometry と同じ
+ *  - ゲイン POSE_GAIN_ONE を 1.0 とした固定小数点
+ *
+ * 例)
+ * @code
+ *  S_UnderBody Omni4(&Serial1);
+ *  PoseController Pose(&Omni4);
+ *
+ *  void setup(){
+ *      Omni4.begin(115200);
+ *      Pose.useOdometry(true);
+ *      Pose.setTarget(1000, 500, 900);     // (1000mm, 500mm) で 90deg を向く
+ *  }
+ *
+ *  void loop(){
+ *      Pose.update();      // 制御周期ごとに送信する
+ *
+ *      if(Pose.reached(20, 20)){
+ *          ...
+ *      }
+ *  }
+ * @endcode
+ *
+ * @note    位置・姿勢が無いか，受信(または setPose() )から setTimeout() の時間が経過して古い場合は，
+ *          制御周期ごとに UnderBody::stop() を送る @n
+ *          オドメトリの通信が途絶しても，止まった位置のまま前の速度で走り続けないようにするためである
+ */
+class PoseController
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _body     操作する足回りモジュール
+     * @param _period   制御周期[ms]
+     */
+    PoseController(UnderBody *_body, unsigned int _period = POSE_CTRL_PERIOD);
+
+    /**
+     * ゲインを設定する
+     *
+     * @param _kpXY     位置の比例ゲイン [1/s] 速度[mm/s] = kpXY * 位置偏差[mm] / POSE_GAIN_ONE
+     * @param _kdXY     位置の微分ゲイン 速度[mm/s] = kdXY * 位置偏差の変化[mm/s] / POSE_GAIN_ONE
+     * @param _kpTheta  姿勢の比例ゲイン [1/s] 旋回速度[deg/s] = kpTheta * 姿勢偏差[deg] / POSE_GAIN_ONE
+     */
+    void setGain(int _kpXY, int _kdXY, int _kpTheta);
+
+    /**
+     * 出力の上限を設定する
+     *
+     * @param _maxVelo  移動速度の上限 @p 0 ~ @p MAX_VELO [mm/s]
+     * @param _maxOmega 旋回速度の上限 @p 0 ~ @p MAX_OMEGA [deg/s]
+     */
+    void setLimit(int _maxVelo, int _maxOmega);
+
+    /**
+     * 目標位置・姿勢を設定する
+     *
+     * @param x         目標位置X [mm]
+     * @param y         目標位置Y [mm]
+     * @param theta     目標姿勢 [0.1deg]
+     */
+    void setTarget(long x, long y, int theta);
+
+    /**
+     * 現在の位置・姿勢を設定する @n
+     * 外部のセンサなどで位置を得る場合に使う
+     *
+     * @param x         現在位置X [mm]
+     * @param y         現在位置Y [mm]
+     * @param theta     現在姿勢 [0.1deg]
+     */
+    void setPose(long x, long y, int theta);
+
+    /**
+     * 現在の位置・姿勢を UnderBody::getOdometry() から得るか設定する
+     *
+     * @param use   @p true ならオドメトリを使う， @p false なら setPose() の値を使う
+     */
+    void useOdometry(bool use);
+
+    /**
+     * 位置・姿勢の有効時間を設定する @n
+     * 受信(または setPose() )から有効時間が経過した位置・姿勢は古いとみなし，制御せずに停止させる
+     *
+     * @param ms    有効時間[ms] 初期値は POSE_TIMEOUT @n
+     *              @p 0 を指定すると古さを確認しない
+     */
+    void setTimeout(unsigned int ms);
+
+    /**
+     * 制御周期が経過していれば移動速度を計算して送信する @n
+     * loop() の中で毎回呼び出す
+     *
+     * @retval -1   現在の位置・姿勢がない，または古い 停止を送った
+     * @retval 0    制御周期が経過していない
+     * @retval 1    送信した
+     */
+    int update();
+
+    /**
+     * 目標位置・姿勢に到達したか確認する
+     *
+     * @param tolXY     位置の許容誤差 [mm] X,Y それぞれ
+     * @param tolTheta  姿勢の許容誤差 [0.1deg]
+     *
+     * @retval true     到達した
+     * @retval false    到達していない，または現在の位置・姿勢がない，古い
+     */
+    bool reached(int tolXY, int tolTheta);
+
+private:
+
+    /**
+     * 現在の位置・姿勢を更新する
+     *
+     * @retval true     現在の位置・姿勢があり，有効時間内である
+     */
+    bool readPose();
+
+    UnderBody *body;
+
+    unsigned int period;
+    unsigned long lastTime;
+
+    int kpXY;
+    int kdXY;
+    int kpTheta;
+
+    int maxVelo;
+    int maxOmega;
+
+    long targetX;
+    long targetY;
+    int targetTheta;
+
+    long poseX;
+    long poseY;
+    int poseTheta;
+    bool poseValid;
+
+    /**
+     * 位置・姿勢を得た時刻[us]
+     */
+    unsigned long poseTime;
+
+    /**
+     * 位置・姿勢の有効時間[ms]
+     */
+    unsigned int timeout;
+
+    bool odometry;
+
+    /**
+     * 前回の位置偏差 [mm] 微分に使う
+     */
+    long prevErrX;
+    long prevErrY;
+    bool prevValid;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @file ReplayTransport.cpp
+ * @brief ReplayTransport クラスメンバの実装
+ */
+
+#include "ReplayTransport.h"
+
+
+ReplayTransport::ReplayTransport(const uint8_t *_log, int _len) : LoopbackTransport(), rx(_log, _len), tx(_log, _len){
+    rewind();
+}
+
+void ReplayTransport::rewind(){
+    rx.rewind();
+    tx.rewind();
+
+    matched = 0;
+    mismatched = 0;
+    extra = 0;
+    emitted = 0;
+    firstMismatch = -1;
+}
+
+void ReplayTransport::setTime(unsigned long time){
+    rx.setTime(time);
+}
+
+unsigned long ReplayTransport::getEndTime(){
+    return rx.getEndTime();
+}
+
+bool ReplayTransport::sendFrame(const uint8_t *frame, int len){
+    uint8_t type;
+    unsigned long time;
+    uint8_t data[REC_MAX_LEN];
+    int recLen;
+
+    LoopbackTransport::sendFrame(frame, len);
+
+    do{
+        recLen = tx.next(&type, &time, data);
+    }while(recLen >= 0 && type == REC_RX);
+
+    bool same = recLen == len && memcmp(frame, data, len) == 0;
+
+    if(recLen < 0){
+        extra++;
+    }
+    else if(same){
+        matched++;
+    }
+    else{
+        mismatched++;
+    }
+
+    if(!same && firstMismatch < 0) firstMismatch = (long)emitted;
+
+    emitted++;
+    return true;
+}
+
+int ReplayTransport::readByte(){
+    int data = LoopbackTransport::readByte();
+
+    if(data != -1) return data;
+
+    return rx.readRx();
+}
+
+unsigned long ReplayTransport::getMatched(){
+    return matched;
+}
+
+unsigned long ReplayTransport::getMismatched(){
+    return mismatched;
+}
+
+unsigned long ReplayTransport::getExtra(){
+    return extra;
+}
+
+long ReplayTransport::getFirstMismatch(){
+    return firstMismatch;
+}
+
+int ReplayTransport::getRemaining(){
+    BusReplayer scan = tx;
+    uint8_t type;
+    unsigned long time;
+    uint8_t data[REC_MAX_LEN];
+    int num = 0;
+
+    while(scan.next(&type, &time, data) >= 0){
+        if(type != REC_RX) num++;
+    }
+
+    return num;
+}
\ No newline at end of file
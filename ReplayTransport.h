@@ -0,0 +1,142 @@
+/**
+ * @file ReplayTransport.h
+ * @brief 記録した通信を Transport として再生し，送信を比較する
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef REPLAY_TRANSPORT_H
+#define REPLAY_TRANSPORT_H
+
+#include <Arduino.h>
+
+#include "BusRecorder.h"
+#include "Transport.h"
+
+
+/**
+ * @brief 記録を再生する Transport
+ *
+ *
+ * 記録した受信データを再生時刻に合わせて T_Fets , T_UnderBody などの FrameListener に与え，
+ * 送信されたフレームを記録した送信フレーム( REC_FET_TX , REC_UB_TX )と順番に比較する @n
+ * 同じ記録で修正前と修正後のコードを動かし，送信が変わっていないか，どこから変わったかを調べられる
+ *
+ * test/Arduino.h を使えばホストでビルドできる (test/replay_test.cpp)
+ *
+ * 例) ホスト側で記録を再生し，送信を比較する
+ * @code
+ *  ReplayTransport Replay(log, logSize);
+ *  T_Fets Module_R(&Replay);
+ *  T_UnderBody Omni4(&Replay);
+ *
+ *  for(unsigned long t = 0; t <= Replay.getEndTime(); t += 10000){
+ *      Replay.setTime(t);
+ *      Replay.pollFrames();
+ *
+ *      // 記録したときと同じ制御
+ *      if(Module_R.getInputState(Fets::In1)) Omni4.stop();
+ *  }
+ *
+ *  if(Replay.getMismatched() > 0 || Replay.getExtra() > 0){
+ *      printf("%ld 番目の送信フレームから変わった\n", Replay.getFirstMismatch());
+ *  }
+ * @endcode
+ *
+ * @note    T_Fets , T_UnderBody で記録するときは受信データを Transport::attachRecorder() で記録する
+ * @note    LoopbackTransport::inject() で入れたデータは記録より先に与える
+ * @note    送信フレームは時刻に関係なく順番だけで比較する
+ */
+class ReplayTransport : public LoopbackTransport
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _log      記録
+     * @param _len      記録の大きさ[byte]
+     */
+    ReplayTransport(const uint8_t *_log, int _len);
+
+    /**
+     * 先頭に戻し，比較の結果を消す
+     */
+    void rewind();
+
+    /**
+     * 再生時刻を設定する
+     *
+     * @param time      再生時刻[us] 記録の先頭が @p 0
+     */
+    void setTime(unsigned long time);
+
+    /**
+     * @return 最後の記録の時刻[us]
+     */
+    unsigned long getEndTime();
+
+    /**
+     * 送信フレームを次の記録した送信フレームと比較する @n
+     * connect() でつないだ相手があれば送る
+     *
+     * @return 常に @p true 比較の結果は getMismatched() などで確認する
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    /**
+     * inject() で入れたデータ，再生時刻までに受信したデータの順に1byte返す
+     */
+    int readByte(); //override
+
+    /**
+     * @return 記録と一致した送信フレームの数
+     */
+    unsigned long getMatched();
+
+    /**
+     * @return 記録と一致しなかった送信フレームの数
+     */
+    unsigned long getMismatched();
+
+    /**
+     * @return 記録した送信フレームを使い切った後に送信したフレームの数
+     */
+    unsigned long getExtra();
+
+    /**
+     * @retval -1       すべて一致している
+     * @retval 0以上    最初に一致しなかった送信フレームの番号 最初の送信が @p 0
+     */
+    long getFirstMismatch();
+
+    /**
+     * @return まだ比較していない記録した送信フレームの数
+     */
+    int getRemaining();
+
+private:
+
+    /**
+     * 受信データを読む位置
+     */
+    BusReplayer rx;
+
+    /**
+     * 送信フレームを比較する位置
+     */
+    BusReplayer tx;
+
+    unsigned long matched;
+    unsigned long mismatched;
+    unsigned long extra;
+
+    /**
+     * 送信したフレームの数
+     */
+    unsigned long emitted;
+
+    long firstMismatch;
+};
+
+#endif
\ No newline at end of file
@@ -1,13 +1,66 @@
 /**
  * @file Sakura_modules.cpp
- * @brief GR-SAKURA 実装用クラス ( S_Fets , S_UnderBody ) メンバの実装
+ * @brief GR-SAKURA 実装用クラス ( SerialTransport , RS485Transport , S_Fets , S_UnderBody ) メンバの実装
  */
 
 
 #include "Sakura_modules.h"
 
+SerialTransport::SerialTransport(HardwareSerial *_comm) : Transport(){
+    comm = _comm;
+}
+
+void SerialTransport::begin(int baudrate){
+    comm->begin(baudrate);
+}
+
+bool SerialTransport::sendFrame(const uint8_t *frame, int len){
+    comm->write(frame, len);
+    return true;
+}
+
+int SerialTransport::readByte(){
+    return comm->read();
+}
+
+
+
+RS485Transport::RS485Transport(HardwareSerial *_comm, int _dePin) : SerialTransport(_comm){
+    dePin = _dePin;
+    turnaround = 87;    // 115200[bps] の1文字分
+}
+
+void RS485Transport::begin(int baudrate){
+    pinMode(dePin, OUTPUT);
+    digitalWrite(dePin, LOW);
+
+    turnaround = (unsigned int)((10000000UL + baudrate - 1) / baudrate);     // 1文字 10bit 分 切り上げ
+
+    SerialTransport::begin(baudrate);
+}
+
+void RS485Transport::setTurnaround(unsigned int us){
+    turnaround = us;
+}
+
+bool RS485Transport::sendFrame(const uint8_t *frame, int len){
+    digitalWrite(dePin, HIGH);
+
+    comm->write(frame, len);
+    comm->flush();                      // 送信バッファが空になるまで待つ
+    delayMicroseconds(turnaround);      // 最後のbyteがシフトレジスタから出るまで待つ
+
+    digitalWrite(dePin, LOW);
+    return true;
+}
+
+
+
+#if USE_FET == 1
+
 S_Fets::S_Fets(HardwareSerial *_comm, char _id, Fets::portNum outputPort, Fets::portNum inputPort) : Fets(_id, outputPort, inputPort){
     comm = _comm;
+    queue = NULL;
 }
 
 void S_Fets::begin(int baudrate){
@@ -22,10 +75,26 @@ int S_Fets::recieve(){
     return comm->read();
 }
 
+void S_Fets::setQueue(FrameQueue *_queue){
+    queue = _queue;
+}
+
+bool S_Fets::sendFrame(const uint8_t *frame, int len){
+    if(queue != NULL) return queue->push(frame, len);
+
+    comm->write(frame, len);
+    return true;
+}
+
+#endif
+
 
 
+#if USE_UNDERBODY == 1
+
 S_UnderBody::S_UnderBody(HardwareSerial *_comm) : UnderBody(){
     comm = _comm;
+    queue = NULL;
 }
 
 void S_UnderBody::begin(int baudrate){
@@ -34,4 +103,21 @@ void S_UnderBody::begin(int baudrate){
 
 void S_UnderBody::send(char data){
     comm->write(data);
-}
\ No newline at end of file
+}
+
+int S_UnderBody::recieve(){
+    return comm->read();
+}
+
+void S_UnderBody::setQueue(FrameQueue *_queue){
+    queue = _queue;
+}
+
+bool S_UnderBody::sendFrame(const uint8_t *frame, int len){
+    if(queue != NULL) return queue->push(frame, len);
+
+    comm->write(frame, len);
+    return true;
+}
+
+#endif
\ No newline at end of file
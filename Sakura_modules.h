@@ -2,7 +2,8 @@
  * @file    Sakura_modules.h
  * @brief   GR-SAKURA でモジュールを使用するための主機能の通信拡張 @n
  *          Fets の拡張 S_Fets @n
- *          UnderBody の拡張 S_UnderBody
+ *          UnderBody の拡張 S_UnderBody @n
+ *          Transport の拡張 SerialTransport , RS485Transport
  * @author  Yuki HONMA @ ProjectR
  * @date    2019/10/17
  */
@@ -13,15 +14,109 @@
 
 #include <Arduino.h>
 
+#include "ModulesConfig.h"      // USE_FET , USE_UNDERBODY の選択
+#include "FrameQueue.h"
+#include "Transport.h"
 
-#define USE_FET 1       /**< FETモジュールライブラリの使用の有無を選択する． 使用時は1，不使用時は0にする． */
-#define USE_UNDERBODY 1 /**< UnderBodyモジュールライブラリの使用の有無を選択する． 使用時は1，不使用時は0にする */
+
+/**
+ * @brief シリアル通信の Transport の GR-SAKURA 実装用クラス
+ *
+ *
+ * HardwareSerial をそのまま通信路として使う @n
+ * T_Fets , T_UnderBody を複数つないでも受信データを取り合わない
+ *
+ * @note    UARTでは複数のモジュールの送信がぶつかるため，モジュールからマスターへ送信できるのは1モジュールのみである @n
+ *          複数のモジュールから受信する場合は RS485Transport を使う
+ */
+class SerialTransport : public Transport
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _comm 通信に使用するハードウェアシリアルのポインタ
+     */
+    SerialTransport(HardwareSerial *_comm);
+
+    /**
+     * シリアル通信を開始する．
+     *
+     * @param baudrate ボーレート
+     */
+    void begin(int baudrate = 115200);
+
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    int readByte(); //override
+
+protected:
+    HardwareSerial *comm;
+};
+
+
+/**
+ * @brief 半二重 RS-485 の Transport の GR-SAKURA 実装用クラス
+ *
+ *
+ * 送信の間だけトランシーバのDE(送信許可)ピンを HIGH にし，それ以外は受信にする @n
+ * 全モジュールが1本のバスを共有し，それぞれのモジュールの状態通知を受信できる
+ *
+ * @note    送信は送信完了まで待つ 115200[bps] で 4byte のフレームは切り替えの待ちを含めて約440[us]かかる
+ * @note    HardwareSerial::flush() は送信バッファが空になるまで待つだけで，最後の1byteのストップビットが
+ *          シフトレジスタから出終わる(SCI の TEND)までは待たないとみなす @n
+ *          そのため flush() の後に setTurnaround() の時間(標準は1文字分)待ってからDEを戻す
+ * @note    モジュール側は，マスターの送信やほかのモジュールの送信と重ならないように応答する必要がある
+ * @attention   RE(受信許可)ピンを DE と逆論理でつなぎ，自分の送信を受信しない配線にすること
+ */
+class RS485Transport : public SerialTransport
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _comm     通信に使用するハードウェアシリアルのポインタ
+     * @param _dePin    トランシーバのDEピン
+     */
+    RS485Transport(HardwareSerial *_comm, int _dePin);
+
+    /**
+     * シリアル通信を開始し，受信状態にする．
+     *
+     * @param baudrate ボーレート
+     */
+    void begin(int baudrate = 115200);
+
+    /**
+     * 送信状態にしてフレームを送信し，送信完了を待って受信状態に戻す
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    /**
+     * flush() の後，DEを戻すまでに待つ時間を設定する @n
+     * begin() でボーレートから1文字(10bit)分の時間に設定されるので，変える場合は begin() の後に呼ぶ
+     *
+     * @param us    待つ時間[us] flush() が TEND まで待つ環境では @p 0 でよい
+     */
+    void setTurnaround(unsigned int us);
+
+private:
+    int dePin;
+
+    /**
+     * flush() の後，DEを戻すまでに待つ時間[us]
+     */
+    unsigned int turnaround;
+};
 
 
 
 #if USE_FET == 1
 
 #include "Fets.h"
+#include "FetPort.h"
 
 
 /**
@@ -137,6 +232,47 @@
  */
 
 
+/**
+ * 使用例3
+ * @code
+ *
+ *  #include <Arduino.h>
+ *
+ *  #include "Sakura_modules.h"
+ *
+ *  #define FET_MOD_ID 0x90
+ *
+ *  // モジュールとして1つだけ実体化し，ポートはハンドルで扱う
+ *  // 通信と受信バッファはすべてのハンドルで共有される
+ *  S_Fets FetModule(&Serial1, FET_MOD_ID);
+ *
+ *  Fets::Port Sorenoid1 = FetModule.port(Fets::Out1, Fets::In1);
+ *  Fets::Port Sorenoid2 = FetModule.port(Fets::Out2, Fets::In1);
+ *  Fets::Port Lamp      = FetModule.port(Fets::Out5);
+ *
+ *  void setup(){
+ *      Serial1.begin(115200);
+ *  }
+ *
+ *  void loop(){
+ *
+ *      Sorenoid1.sensorResponce(0, 0);
+ *      Sorenoid2.sensorResponce(0, 1);
+ *
+ *      if(FetModule.getInputState(Fets::In3)){
+ *          Lamp.write(1);
+ *      }
+ *      else{
+ *          Lamp.writeWave(Fets::Square, 500);
+ *      }
+ *
+ *      delay(10);
+ *  }
+ *
+ * @endcode
+ */
+
+
 /**
  * @brief FETモジュール操作機能の GR-SAKURA 実装用クラス
  *
@@ -178,6 +314,21 @@ public:
      */
     void begin(int baudrate = 115200);
 
+    /**
+     * 送信フレームを積む待ち行列を設定する
+     *
+     * 設定するとシリアル通信へは書き込まず待ち行列に積む @n
+     * 待ち行列の所有者が FrameQueue::drain() で送信する @n
+     * 満杯で積めなかったときは，送信したメソッドが FET_ERR_DROPPED を返す
+     *
+     * @param _queue    待ち行列 @n
+     *                  NULL を指定するとシリアル通信に直接書き込む
+     *
+     * @note    割り込みから使用する実体に設定する @n
+     *          割り込みと loop() の両方から使う場合は FrameQueueMP を設定する
+     */
+    void setQueue(FrameQueue *_queue);
+
 protected:
 
     /**
@@ -188,6 +339,18 @@ protected:
      */
     void send(char data); //override
 
+    /**
+     * フレームをまとめて送信するメソッド @n
+     * 待ち行列が設定されていれば積み，なければシリアル通信に書き込む
+     *
+     * @param frame 送信するフレーム
+     * @param len   フレームの長さ
+     *
+     * @retval true     送信した，または積んだ
+     * @retval false    待ち行列が満杯で捨てた
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
     /**
      * シリアル通信での受信メソッド @n
      * 外部呼び出しはされない
@@ -200,6 +363,8 @@ protected:
 private:
 
     HardwareSerial *comm;
+
+    FrameQueue *queue;
 };
 
 #endif
@@ -276,7 +441,7 @@ private:
  * UnderBody クラスを継承した拡張クラス @n
  * UnderBody クラスのパブリックメンバをそのまま呼び出せる
  *
- * GR-SAKURA のシリアル通信 HardwareSerial を使用して send() メソッドをオーバーライドしている
+ * GR-SAKURA のシリアル通信 HardwareSerial を使用して send() , recieve() メソッドをオーバーライドしている
  */
 class S_UnderBody : public UnderBody
 {
@@ -299,6 +464,17 @@ public:
      */
     void begin(int baudrate = 115200);
 
+    /**
+     * 送信フレームを積む待ち行列を設定する
+     *
+     * @param _queue    待ち行列 @n
+     *                  NULL を指定するとシリアル通信に直接書き込む
+     *
+     * @note    満杯で積めなかったときは，送信したメソッドが MOVE_ERR_DROPPED を返す
+     * @see S_Fets::setQueue()
+     */
+    void setQueue(FrameQueue *_queue);
+
 protected:
 
     /**
@@ -309,9 +485,32 @@ protected:
      */
     void send(char data); //override
 
+    /**
+     * フレームをまとめて送信するメソッド @n
+     * 待ち行列が設定されていれば積み，なければシリアル通信に書き込む
+     *
+     * @param frame 送信するフレーム
+     * @param len   フレームの長さ
+     *
+     * @retval true     送信した，または積んだ
+     * @retval false    待ち行列が満杯で捨てた
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    /**
+     * シリアル通信での受信メソッド @n
+     * 外部呼び出しはされない
+     *
+     * @return @p -1 新規データなし
+     * @return @p 0x00 ~ @p 0xFF 受信したデータ
+     */
+    int recieve(); //override
+
 private:
     HardwareSerial *comm;
 
+    FrameQueue *queue;
+
 };
 #endif
 
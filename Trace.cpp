@@ -0,0 +1,81 @@
+/**
+ * @file Trace.cpp
+ * @brief Trace クラスメンバの実装
+ */
+
+#include "Trace.h"
+
+#if USE_TRACE == 1
+
+
+Trace::record Trace::buff[TRACE_SIZE];
+const char *Trace::names[TRACE_MAX_ID] = {
+    NULL, "Fets::sendData", "Fets::recvData", "UnderBody::sendData"
+};
+volatile unsigned int Trace::head = 0;
+volatile unsigned long Trace::total = 0;
+
+void Trace::add(uint8_t id, unsigned long start, unsigned long end){
+    unsigned long duration = end - start;
+    unsigned int index = head;
+
+    head = (index + 1) % TRACE_SIZE;
+    total++;
+
+    buff[index].start = start;
+    buff[index].duration = (duration > 0xFFFF) ? 0xFFFF : (uint16_t)duration;
+    buff[index].id = id;
+}
+
+int Trace::setName(uint8_t id, const char *name){
+    if(id == 0 || id >= TRACE_MAX_ID) return -1;
+
+    names[id] = name;
+    return 0;
+}
+
+int Trace::dump(Print *out){
+    int num = count();
+    unsigned int index = (head + TRACE_SIZE - num) % TRACE_SIZE;
+
+    out->print("{\"traceEvents\":[\n");
+
+    for(int i=0; i<num; i++){
+        const record &rec = buff[index];
+
+        out->print("{\"name\":\"");
+        if(rec.id < TRACE_MAX_ID && names[rec.id] != NULL){
+            out->print(names[rec.id]);
+        }
+        else{
+            out->print("id");
+            out->print((unsigned int)rec.id);
+        }
+        out->print("\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":");
+        out->print(rec.start);
+        out->print(",\"dur\":");
+        out->print((unsigned int)rec.duration);
+        out->print((i < num - 1) ? "},\n" : "}\n");
+
+        index = (index + 1) % TRACE_SIZE;
+    }
+
+    out->print("]}\n");
+
+    return num;
+}
+
+void Trace::clear(){
+    head = 0;
+    total = 0;
+}
+
+int Trace::count(){
+    return (total < TRACE_SIZE) ? (int)total : TRACE_SIZE;
+}
+
+unsigned long Trace::getLost(){
+    return (total < TRACE_SIZE) ? 0 : total - TRACE_SIZE;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+/**
+ * @file Trace.h
+ * @brief 処理時間を計測して記録するプロファイル機能
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+
+#define USE_TRACE 0     /**< 処理時間の記録の有無を選択する． 使用時は1，不使用時は0にする． 不使用時は TRACE() が何もしない */
+
+#define TRACE_SIZE 128          /**< 記録できる区間の数 満杯になると古いものから上書きする */
+#define TRACE_MAX_ID 32         /**< 区間の種類の数 */
+
+#define TRACE_FET_SEND 1        /**< 区間の種類 Fets::sendData() */
+#define TRACE_FET_RECV 2        /**< 区間の種類 Fets::recvData() */
+#define TRACE_UB_SEND 3         /**< 区間の種類 UnderBody::sendData() */
+#define TRACE_USER 8            /**< 区間の種類 ユーザーが使える最初の番号 @p TRACE_USER ~ @p TRACE_MAX_ID-1 */
+
+
+#define TRACE_CAT_(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT_(a, b)
+
+
+#if USE_TRACE == 1
+
+/**
+ * スコープの開始から終了までの時間を記録する
+ *
+ * @param id    区間の種類 @p 1 ~ @p TRACE_MAX_ID-1
+ */
+#define TRACE(id) TraceScope TRACE_CAT(traceScope, __LINE__)(id)
+
+
+/**
+ * @brief 処理時間の記録クラス
+ *
+ *
+ * TRACE() で囲んだ区間の開始時刻と長さをRAM上のリングバッファに記録し，
+ * dump() で Chrome trace 形式のJSONとして書き出す @n
+ * 書き出したファイルは chrome://tracing や Perfetto でそのまま開ける
+ *
+ * 標準で Fets::sendData() , Fets::recvData() , UnderBody::sendData() を記録する
+ *
+ * 例) 制御周期の内訳を見る
+ * @code
+ *  void setup(){
+ *      Trace::setName(TRACE_USER, "control");
+ *  }
+ *
+ *  void loop(){
+ *      {
+ *          TRACE(TRACE_USER);
+ *          Omni4.moveXY(vX, vY, omega);
+ *          Module_S.recvData();
+ *      }
+ *
+ *      if(Serial.read() == 'd') Trace::dump(&Serial);
+ *  }
+ * @endcode
+ *
+ * @note    時刻は micros() [us] である 区間の長さは 65535[us] で飽和する
+ * @note    記録1回あたり micros() 2回と数十命令かかる
+ * @attention 割り込みの中と同時に記録すると，記録が1つ壊れることがある
+ */
+class Trace
+{
+public:
+
+    /**
+     * 1区間の記録
+     */
+    struct record{
+        unsigned long start;    /**< 開始時刻[us] */
+        uint16_t duration;      /**< 長さ[us] */
+        uint8_t id;             /**< 区間の種類 */
+    };
+
+    /**
+     * 区間を記録する @n
+     * 通常は TRACE() から呼ばれる
+     *
+     * @param id        区間の種類
+     * @param start     開始時刻[us]
+     * @param end       終了時刻[us]
+     */
+    static void add(uint8_t id, unsigned long start, unsigned long end);
+
+    /**
+     * 区間の種類に名前をつける
+     *
+     * @param id    区間の種類 @p 1 ~ @p TRACE_MAX_ID-1
+     * @param name  名前 文字列は書き出すまで保持すること
+     *
+     * @retval -1   区間の種類が不正
+     * @retval 0    正常
+     */
+    static int setName(uint8_t id, const char *name);
+
+    /**
+     * 記録を Chrome trace 形式のJSONで書き出す
+     *
+     * @param out   書き出し先 &Serial など
+     *
+     * @return  書き出した区間の数
+     *
+     * @note    書き出し中の記録は止めないので，書き出しの処理自体も記録されることがある
+     */
+    static int dump(Print *out);
+
+    /**
+     * 記録を消す
+     */
+    static void clear();
+
+    /**
+     * @return 記録している区間の数
+     */
+    static int count();
+
+    /**
+     * @return 上書きして失った区間の数
+     */
+    static unsigned long getLost();
+
+private:
+
+    static record buff[TRACE_SIZE];
+    static const char *names[TRACE_MAX_ID];
+    static volatile unsigned int head;
+    static volatile unsigned long total;
+};
+
+
+/**
+ * @brief TRACE() が使う計測クラス
+ *
+ * 生成時の時刻を覚え，破棄されるときに Trace::add() で記録する
+ */
+class TraceScope
+{
+public:
+    TraceScope(uint8_t _id){
+        id = _id;
+        start = micros();
+    }
+
+    ~TraceScope(){
+        Trace::add(id, start, micros());
+    }
+
+private:
+    unsigned long start;
+    uint8_t id;
+};
+
+#else
+
+#define TRACE(id)
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,186 @@
+/**
+ * @file Transport.cpp
+ * @brief Transport , LoopbackTransport , T_Fets , T_UnderBody クラスメンバの実装
+ */
+
+#include "Transport.h"
+#include "BusRecorder.h"
+
+
+Transport::Transport(){
+    listenerNum = 0;
+    recorder = NULL;
+    polling = false;
+}
+
+int Transport::pollFrames(){
+    int getNum = 0;
+    int data;
+
+    if(polling) return 0;
+    polling = true;
+
+    while((data = readByte()) != -1){
+        if(recorder != NULL) recorder->recordRx((uint8_t)data);
+
+        for(int i=0; i<listenerNum; i++){
+            listeners[i]->onByte((uint8_t)data);
+        }
+        getNum++;
+    }
+
+    polling = false;
+
+    return getNum;
+}
+
+int Transport::attach(FrameListener *listener){
+    for(int i=0; i<listenerNum; i++){
+        if(listeners[i] == listener) return 0;
+    }
+
+    if(listenerNum >= TRANSPORT_MAX_LISTENER) return -1;
+
+    listeners[listenerNum++] = listener;
+    return 0;
+}
+
+void Transport::attachRecorder(BusRecorder *_recorder){
+    recorder = _recorder;
+}
+
+void Transport::detach(FrameListener *listener){
+    for(int i=0; i<listenerNum; i++){
+        if(listeners[i] == listener){
+            listeners[i] = listeners[--listenerNum];
+            return;
+        }
+    }
+}
+
+
+
+LoopbackTransport::LoopbackTransport() : Transport(){
+    peer = NULL;
+    head = 0;
+    tail = 0;
+    dropped = 0;
+}
+
+void LoopbackTransport::connect(LoopbackTransport *_peer){
+    if(peer != NULL && peer != _peer) peer->peer = NULL;
+
+    peer = _peer;
+    if(peer != NULL) peer->peer = this;
+}
+
+bool LoopbackTransport::sendFrame(const uint8_t *frame, int len){
+    if(peer == NULL) return false;
+
+    return peer->inject(frame, len) == len;
+}
+
+int LoopbackTransport::readByte(){
+    if(head == tail) return -1;
+
+    uint8_t data = buff[tail];
+    tail = (tail + 1) % LOOPBACK_SIZE;
+
+    return data;
+}
+
+int LoopbackTransport::inject(const uint8_t *data, int len){
+    for(int i=0; i<len; i++){
+        uint8_t next = (head + 1) % LOOPBACK_SIZE;
+
+        if(next == tail){
+            dropped += len - i;
+            return i;
+        }
+
+        buff[head] = data[i];
+        head = next;
+    }
+
+    return len;
+}
+
+unsigned int LoopbackTransport::getDropped(){
+    return dropped;
+}
+
+
+
+#if USE_FET == 1
+
+T_Fets::T_Fets(Transport *_link, char _id, portNum outputPort, portNum inputPort) : Fets(_id, outputPort, inputPort){
+    link = _link;
+    queue = NULL;
+    link->attach(this);
+}
+
+void T_Fets::onByte(uint8_t data){
+    parseByte(data);
+}
+
+void T_Fets::send(char data){
+    uint8_t frame = (uint8_t)data;
+
+    link->sendFrame(&frame, 1);
+}
+
+void T_Fets::setQueue(FrameQueue *_queue){
+    queue = _queue;
+}
+
+bool T_Fets::sendFrame(const uint8_t *frame, int len){
+    if(queue != NULL) return queue->push(frame, len);
+
+    return link->sendFrame(frame, len);
+}
+
+int T_Fets::recieve(){
+    link->pollFrames();
+
+    return -1;
+}
+
+#endif
+
+
+
+#if USE_UNDERBODY == 1
+
+T_UnderBody::T_UnderBody(Transport *_link) : UnderBody(){
+    link = _link;
+    queue = NULL;
+    link->attach(this);
+}
+
+void T_UnderBody::onByte(uint8_t data){
+    parseByte(data);
+}
+
+void T_UnderBody::send(char data){
+    uint8_t frame = (uint8_t)data;
+
+    link->sendFrame(&frame, 1);
+}
+
+void T_UnderBody::setQueue(FrameQueue *_queue){
+    queue = _queue;
+}
+
+bool T_UnderBody::sendFrame(const uint8_t *frame, int len){
+    if(queue != NULL) return queue->push(frame, len);
+
+    return link->sendFrame(frame, len);
+}
+
+int T_UnderBody::recieve(){
+    link->pollFrames();
+
+    return -1;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,359 @@
+/**
+ * @file Transport.h
+ * @brief モジュールとの通信路を差し替えるための抽象化
+ * @author Yuki HONMA @ ProjectR
+ * @date 2026/10/19
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <Arduino.h>
+
+#include "ModulesConfig.h"
+#include "FrameQueue.h"
+
+#if USE_FET == 1
+#include "Fets.h"
+#endif
+#if USE_UNDERBODY == 1
+#include "UnderBody.h"
+#endif
+
+class BusRecorder;
+
+#define TRANSPORT_MAX_LISTENER 8    /**< 1つの通信路で受信できるクラスの数 */
+#define LOOPBACK_SIZE 64            /**< LoopbackTransport の受信バッファの大きさ[byte] */
+
+
+/**
+ * @brief 受信データを受け取るインターフェース
+ *
+ * Transport::attach() で登録すると， Transport::pollFrames() で受信した全データを1byteずつ受け取る
+ */
+class FrameListener
+{
+public:
+
+    /**
+     * 受信データを1byte受け取る
+     *
+     * @param data  受信したデータ
+     */
+    virtual void onByte(uint8_t data) = 0;
+};
+
+
+/**
+ * @brief 通信路の抽象クラス
+ *
+ *
+ * フレームの形式には関与せず，フレームをまとめて送信し，受信データを登録したすべての FrameListener に配る @n
+ * 1つの通信路を複数のモジュールで共有しても，受信データを取り合わないので，
+ * すべてのモジュールからの状態通知を受信できる
+ *
+ * sendFrame() , readByte() が純粋仮想関数である
+ *
+ * 例) RS-485 のバスに足回りとFETモジュール2台をつなぐ
+ * @code
+ *  RS485Transport Bus(&Serial1, PIN_DE);
+ *
+ *  T_UnderBody Omni4(&Bus);
+ *  T_Fets Module_A(&Bus, 0x90);
+ *  T_Fets Module_B(&Bus, 0x91);
+ *
+ *  void setup(){
+ *      Bus.begin(115200);
+ *  }
+ *
+ *  void loop(){
+ *      Bus.pollFrames();       // 3台分の受信をまとめて処理する
+ *
+ *      if(Module_B.getInputState(Fets::In1)) Module_A.write(1, Fets::Out1);
+ *      Omni4.moveXY(vX, vY, omega);
+ *  }
+ * @endcode
+ */
+class Transport
+{
+public:
+
+    /**
+     * コンストラクタ
+     */
+    Transport();
+
+    /**
+     * フレームを送信する
+     *
+     * @param frame 送信するフレーム
+     * @param len   フレームの長さ
+     *
+     * @retval true     送信した，または送信待ちに積んだ
+     * @retval false    送れずに捨てた
+     */
+    virtual bool sendFrame(const uint8_t *frame, int len) = 0;
+
+    /**
+     * 受信データを1byte読む
+     *
+     * @retval -1       新規データなし
+     * @retval 0~0xFF   受信したデータ
+     */
+    virtual int readByte() = 0;
+
+    /**
+     * 受信したデータをすべて読み，登録した FrameListener に配る
+     *
+     * @return  読んだデータ数
+     *
+     * @note    FrameListener の中から呼び出された場合は何もしない
+     */
+    int pollFrames();
+
+    /**
+     * 受信データを受け取るクラスを登録する
+     *
+     * @param listener  登録するクラス
+     *
+     * @retval -1   登録数の上限
+     * @retval 0    正常 登録済みなら何もしない
+     */
+    int attach(FrameListener *listener);
+
+    /**
+     * 受信データを受け取るクラスの登録を解除する
+     *
+     * @param listener  解除するクラス
+     */
+    void detach(FrameListener *listener);
+
+    /**
+     * 受信データを記録する BusRecorder を設定する
+     *
+     * 設定すると pollFrames() で受信したデータを1byteにつき1回記録する @n
+     * 送信フレームは T_Fets , T_UnderBody の attachRecorder() で記録する
+     *
+     * @param _recorder 記録先 @n
+     *                  NULL を指定すると記録しない
+     */
+    void attachRecorder(BusRecorder *_recorder);
+
+private:
+
+    FrameListener *listeners[TRANSPORT_MAX_LISTENER];
+    uint8_t listenerNum;
+
+    /**
+     * 受信データの記録先
+     */
+    BusRecorder *recorder;
+
+    /**
+     * pollFrames() の実行中
+     */
+    bool polling;
+};
+
+
+/**
+ * @brief メモリ上の通信路
+ *
+ *
+ * connect() でつないだ相手の受信バッファに送信フレームを書き込む @n
+ * モジュールの代わりに inject() で受信データを入れられるので，実機なしで動作を確認できる
+ *
+ * 例)
+ * @code
+ *  LoopbackTransport Master, Module;
+ *  T_Fets Fet(&Master);
+ *
+ *  void setup(){
+ *      Master.connect(&Module);
+ *
+ *      Fet.write(1, Fets::Out1);       // Module.readByte() で読める
+ *
+ *      const uint8_t state[4] = {0x01, 0x02, 0x03, DEF_ID};
+ *      Master.inject(state, 4);
+ *      Fet.getInputState(Fets::In1);   // 1
+ *  }
+ * @endcode
+ */
+class LoopbackTransport : public Transport
+{
+public:
+
+    /**
+     * コンストラクタ
+     */
+    LoopbackTransport();
+
+    /**
+     * 相手の通信路とつなぐ 相手からもつながる
+     *
+     * @param _peer 相手の通信路 @n
+     *              NULL を指定すると切断する
+     */
+    void connect(LoopbackTransport *_peer);
+
+    /**
+     * 相手の受信バッファにフレームを書き込む @n
+     * つながっていないか，相手の受信バッファに入りきらなければ @p false を返す
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    int readByte(); //override
+
+    /**
+     * 自分の受信バッファにデータを入れる
+     *
+     * @param data  データ
+     * @param len   データの長さ
+     *
+     * @return  入れたデータ数 満杯で入らなかった分は捨てる
+     */
+    int inject(const uint8_t *data, int len);
+
+    /**
+     * @return 満杯で捨てたデータ数
+     */
+    unsigned int getDropped();
+
+private:
+
+    LoopbackTransport *peer;
+
+    uint8_t buff[LOOPBACK_SIZE];
+    uint8_t head;
+    uint8_t tail;
+
+    unsigned int dropped;
+};
+
+
+#if USE_FET == 1
+
+/**
+ * @brief FETモジュール操作機能の Transport 実装用クラス
+ *
+ *
+ * Fets クラスを継承した拡張クラス @n
+ * 送信は Transport::sendFrame() で行い，受信は Transport::pollFrames() から1byteずつ受け取る @n
+ * 同じ通信路の別の実体と受信データを取り合わない
+ *
+ * @note    recvData() , getInputState() などは内部で Transport::pollFrames() を呼ぶので，これまで通り使える @n
+ *          ただし recvData() の戻り値は常に @p 0 である
+ */
+class T_Fets : public Fets, public FrameListener
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _link         モジュールとの通信路
+     * @param _id           モジュールのID
+     * @param outputPort    出力ポートの番号
+     * @param inputPort     入力ポートの番号
+     *
+     * @see Fets::Fets()
+     */
+    T_Fets(Transport *_link, char _id = DEF_ID, portNum outputPort = None, portNum inputPort = None);
+
+    void onByte(uint8_t data); //override
+
+    /**
+     * 送信フレームを積む待ち行列を設定する
+     *
+     * 設定すると通信路へは送らず待ち行列に積む @n
+     * 待ち行列の所有者が FrameQueue::drain(Transport*, int) で通信路に送る
+     *
+     * @param _queue    待ち行列 @n
+     *                  NULL を指定すると通信路に直接送る
+     *
+     * @see S_Fets::setQueue()
+     */
+    void setQueue(FrameQueue *_queue);
+
+protected:
+
+    void send(char data); //override
+
+    /**
+     * 待ち行列が設定されていれば積み，なければ Transport::sendFrame() で送る
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    /**
+     * Transport::pollFrames() を呼び出す @n
+     * 受信データは onByte() で受け取るので，常に @p -1 を返す
+     */
+    int recieve(); //override
+
+private:
+    Transport *link;
+
+    FrameQueue *queue;
+};
+
+#endif
+
+
+#if USE_UNDERBODY == 1
+
+/**
+ * @brief UnderBodyモジュール操作機能の Transport 実装用クラス
+ *
+ *
+ * UnderBody クラスを継承した拡張クラス @n
+ * 送信は Transport::sendFrame() で行い，受信は Transport::pollFrames() から1byteずつ受け取る
+ *
+ * @see T_Fets
+ */
+class T_UnderBody : public UnderBody, public FrameListener
+{
+public:
+
+    /**
+     * コンストラクタ
+     *
+     * @param _link モジュールとの通信路
+     */
+    T_UnderBody(Transport *_link);
+
+    void onByte(uint8_t data); //override
+
+    /**
+     * 送信フレームを積む待ち行列を設定する
+     *
+     * @param _queue    待ち行列 @n
+     *                  NULL を指定すると通信路に直接送る
+     *
+     * @see T_Fets::setQueue()
+     */
+    void setQueue(FrameQueue *_queue);
+
+protected:
+
+    void send(char data); //override
+
+    /**
+     * 待ち行列が設定されていれば積み，なければ Transport::sendFrame() で送る
+     */
+    bool sendFrame(const uint8_t *frame, int len); //override
+
+    /**
+     * Transport::pollFrames() を呼び出す @n
+     * 受信データは onByte() で受け取るので，常に @p -1 を返す
+     */
+    int recieve(); //override
+
+private:
+    Transport *link;
+
+    FrameQueue *queue;
+};
+
+#endif
+
+#endif
\ No newline at end of file
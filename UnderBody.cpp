@@ -5,10 +5,21 @@
 
 
 #include "UnderBody.h"
+#include "BusRecorder.h"
+#include "LinkMonitor.h"
+#include "Trace.h"
+#include "FastTrig.h"
 
 
 UnderBody::UnderBody(){
+    recorder = NULL;
+    monitor = NULL;
+    failsafe = false;
 
+    for(int i=0; i<8; i++){
+        dataBuff[i] = 0;
+    }
+    memset(&odom, 0, sizeof(odom));
 }
 
 int UnderBody::moveXY(int vX, int vY, int omega){
@@ -19,11 +30,17 @@ int UnderBody::moveXY(int vX, int vY, int omega){
     if(omega > MAX_OMEGA)   return -5;
     if(omega < -MAX_OMEGA)  return -6;
 
-    sendData(vX, vY, omega, MOVE_RECT);
-    return 0;
+    return sendData(vX, vY, omega, MOVE_RECT);
 }
 
 int UnderBody::moveXY(double vX, double vY, double omega){
+    if(!(vX <= MAX_VELO/1000.0))    return -1;      // int に変換する前に範囲外と NaN を除く
+    if(!(vX >= -MAX_VELO/1000.0))   return -2;
+    if(!(vY <= MAX_VELO/1000.0))    return -3;
+    if(!(vY >= -MAX_VELO/1000.0))   return -4;
+    if(!(omega <= MAX_OMEGA*PI/180.0))  return -5;
+    if(!(omega >= -MAX_OMEGA*PI/180.0)) return -6;
+
     return moveXY((int)(vX*1000.0), (int)(vY*1000.0), (int)(omega*180.0/PI));
 }
 
@@ -33,50 +50,216 @@ int UnderBody::movePolar(int spd, int dir, int omega){
     if(omega > MAX_OMEGA)   return -3;
     if(omega < -MAX_OMEGA)  return -4;
 
-    while(dir > 360) dir -= 360;
-    while(dir < 0)   dir += 360;
+    dir %= 360;
+    if(dir < 0) dir += 360;
 
-    sendData(spd, dir, omega, MOVE_POLAR);
-    return 0;
+    return sendData(spd, dir, omega, MOVE_POLAR);
 }
 
 int UnderBody::movePolar(double spd, double dir, double omega){
+    if(!(spd <= MAX_VELO/1000.0))   return -1;      // int に変換する前に範囲外と NaN を除く
+    if(!(spd >= -MAX_VELO/1000.0))  return -2;
+    if(!(omega <= MAX_OMEGA*PI/180.0))  return -3;
+    if(!(omega >= -MAX_OMEGA*PI/180.0)) return -4;
+
+    dir = fmod(dir, 2.0*PI);
+    if(!(dir == dir)) dir = 0.0;    // NaN
+
     return movePolar((int)(spd*1000.0), (int)(dir*180.0/PI), (int)(omega*180.0/PI));
 }
 
-void UnderBody::stop(){
-    sendData(0, 0, 0, MOVE_STOP);
+int UnderBody::moveField(int vX, int vY, int omega, int heading){
+    long bodyX, bodyY;
+    long peak;
+
+    if(vX > MAX_VELO)   return -1;
+    if(vX < -MAX_VELO)  return -2;
+    if(vY > MAX_VELO)   return -3;
+    if(vY < -MAX_VELO)  return -4;
+    if(omega > MAX_OMEGA)   return -5;
+    if(omega < -MAX_OMEGA)  return -6;
+
+    heading %= 3600;        // INT_MIN を符号反転しないように先に丸める
+
+    FastTrig::rotate(vX, vY, -heading, &bodyX, &bodyY);
+
+    peak = max(labs(bodyX), labs(bodyY));
+    if(peak > MAX_VELO){        // 斜めに回すと各軸の最大値を超えることがある
+        bodyX = bodyX * MAX_VELO / peak;
+        bodyY = bodyY * MAX_VELO / peak;
+    }
+
+    return sendData((int)bodyX, (int)bodyY, omega, MOVE_RECT);
+}
+
+int UnderBody::moveField(double vX, double vY, double omega, double heading){
+    if(!(vX <= MAX_VELO/1000.0))    return -1;
+    if(!(vX >= -MAX_VELO/1000.0))   return -2;
+    if(!(vY <= MAX_VELO/1000.0))    return -3;
+    if(!(vY >= -MAX_VELO/1000.0))   return -4;
+    if(!(omega <= MAX_OMEGA*PI/180.0))  return -5;
+    if(!(omega >= -MAX_OMEGA*PI/180.0)) return -6;
+
+    heading = fmod(heading, 2.0*PI);
+    if(!(heading == heading)) heading = 0.0;    // NaN
+
+    return moveField((int)(vX*1000.0), (int)(vY*1000.0), (int)(omega*180.0/PI), (int)(heading*1800.0/PI));
+}
+
+int UnderBody::stop(){
+    return sendData(0, 0, 0, MOVE_STOP);
+}
+
+void UnderBody::attachRecorder(BusRecorder *_recorder){
+    recorder = _recorder;
+}
+
+void UnderBody::attachMonitor(LinkMonitor *_monitor){
+    monitor = _monitor;
+}
+
+void UnderBody::setFailsafe(bool lock){
+    failsafe = lock;
+}
+
+bool UnderBody::isFailsafe(){
+    return failsafe;
+}
+
+int UnderBody::recvData(){
+    int getNum = 0;
+    int data;
+
+    while((data = recieve()) != -1){
+        if(recorder != NULL) recorder->recordRx((uint8_t)data);
+        parseByte((uint8_t)data);
+        getNum++;
+    }
+
+    return getNum;
 }
 
-void UnderBody::sendData(int param1, int param2, int param3, uint8_t mode){
+void UnderBody::parseByte(uint8_t data){
+
+    for(int i=0;i<7;i++){
+        dataBuff[i] = dataBuff[i+1];
+    }
+    dataBuff[7] = data;
+
+    if(dataBuff[7] >= ODOM_POSE && dataBuff[7] <= ODOM_STATUS){
+        updateOdometry();
+    }
+}
+
+const UnderBody::odometry &UnderBody::getOdometry(){
+    recvData();
+
+    return odom;
+}
+
+int UnderBody::recieve(){
+    return -1;
+}
+
+void UnderBody::updateOdometry(){
+    int param1, param2, param3;
+    uint8_t type;
+
+    if(decodeFrame(dataBuff, &param1, &param2, &param3, &type) != 0){
+        if(monitor != NULL) monitor->frameError(LINK_ID_UNDERBODY);
+        return;
+    }
+
+    if(monitor != NULL) monitor->frameOk(LINK_ID_UNDERBODY);
+
+    switch(type){
+    case ODOM_POSE:
+        odom.x = (long)param1 * ODOM_POS_UNIT;
+        odom.y = (long)param2 * ODOM_POS_UNIT;
+        odom.theta = param3;
+        odom.poseTime = micros();
+        odom.valid |= ODOM_VALID_POSE;
+        break;
+
+    case ODOM_VELO:
+        odom.vX = param1;
+        odom.vY = param2;
+        odom.omega = param3;
+        odom.veloTime = micros();
+        odom.valid |= ODOM_VALID_VELO;
+        break;
+
+    case ODOM_STATUS:
+        odom.fault = (unsigned int)param1;
+        odom.battery = (unsigned int)param2;
+        odom.statusTime = micros();
+        odom.valid |= ODOM_VALID_STATUS;
+        break;
+    }
+}
+
+int UnderBody::sendData(int param1, int param2, int param3, uint8_t mode){
+    TRACE(TRACE_UB_SEND);
 
     uint8_t data[8] = {};
 
-    if(param1 < 0.0){
-        data[0] = 0x40;
-        param1 *= -1;
-    }    
-    data[0] |= ((param1 >> 7) & 0x3F);
-    data[1] = param1 & 0x7F;
+    if(failsafe && mode != MOVE_STOP) return MOVE_ERR_LOCKED;
+
+    makeFrame(data, param1, param2, param3, mode);
+
+    if(!sendFrame(data, 8)) return MOVE_ERR_DROPPED;
+
+    if(recorder != NULL) recorder->record(REC_UB_TX, data, 8);     // 捨てたフレームは記録しない
+
+    return 0;
+}
+
+int UnderBody::makeFrame(uint8_t *frame, int param1, int param2, int param3, uint8_t mode){
+    int param[3] = {param1, param2, param3};
+
+    for(int i=0; i<3; i++){
+        frame[2*i] = 0;
 
-    if(param2 < 0.0){
-        data[2] = 0x40;
-        param2 *= -1;
+        if(param[i] < 0){
+            frame[2*i] = 0x40;
+            param[i] = (param[i] < -0x1FFF) ? 0x1FFF : -param[i];
+        }
+        else if(param[i] > 0x1FFF){
+            param[i] = 0x1FFF;
+        }
+        frame[2*i] |= ((param[i] >> 7) & 0x3F);
+        frame[2*i + 1] = param[i] & 0x7F;
     }
-    data[2] |= ((param2 >> 7) & 0x3F);
-    data[3] = param2 & 0x7F;
 
-    if(param3 < 0.0){
-        data[4] = 0x40;
-        param3 *= -1;
+    frame[6] = frame[0] ^ frame[1] ^ frame[2] ^ frame[3] ^ frame[4] ^ frame[5];
+    frame[7] = mode;
+
+    return 8;
+}
+
+int UnderBody::decodeFrame(const uint8_t *frame, int *param1, int *param2, int *param3, uint8_t *mode){
+    int *param[3] = {param1, param2, param3};
+    uint8_t check = 0;
+
+    for(int i=0; i<6; i++){
+        if(frame[i] & 0x80) return -1;
+        check ^= frame[i];
     }
-    data[4] |= ((param3 >> 7) & 0x3F);
-    data[5] = param3 & 0x7F;
+    if(frame[6] != check)       return -2;
+    if(!(frame[7] & 0x80))      return -3;
 
-    data[6] = data[0] ^ data[1] ^ data[2] ^ data[3] ^ data[4] ^ data[5];
-    data[7] = mode;
+    for(int i=0; i<3; i++){
+        *param[i] = ((frame[2*i] & 0x3F) << 7) | frame[2*i + 1];
+        if(frame[2*i] & 0x40) *param[i] = -*param[i];
+    }
+    *mode = frame[7];
 
-    for(int i=0; i<8; i++){
-        send(data[i]);
+    return 0;
+}
+
+bool UnderBody::sendFrame(const uint8_t *frame, int len){
+    for(int i=0; i<len; i++){
+        send(frame[i]);
     }
+    return true;
 }
\ No newline at end of file
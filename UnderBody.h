@@ -11,6 +11,9 @@
 
 #include <Arduino.h>
 
+class BusRecorder;
+class LinkMonitor;
+
 #define MOVE_RECT   0xFF
 #define MOVE_POLAR  0xFE
 #define MOVE_STOP   0xF0
@@ -18,16 +21,32 @@
 #define MAX_VELO    8000
 #define MAX_OMEGA   500
 
+#define ODOM_POSE   0xE0    /**< 受信フレームの種類 位置 x,y [ODOM_POS_UNIT mm] , 姿勢 [0.1deg] */
+#define ODOM_VELO   0xE1    /**< 受信フレームの種類 速度 vX,vY [mm/s] , 旋回速度 [deg/s] */
+#define ODOM_STATUS 0xE2    /**< 受信フレームの種類 異常フラグ , 電源電圧 [10mV] , 予備 */
+
+#define ODOM_POS_UNIT 2     /**< 位置の受信フレームでの単位[mm] */
+
+#define ODOM_VALID_POSE   0x01  /**< 受信済みの情報 位置 */
+#define ODOM_VALID_VELO   0x02  /**< 受信済みの情報 速度 */
+#define ODOM_VALID_STATUS 0x04  /**< 受信済みの情報 状態 */
+
+#define MOVE_ERR_LOCKED -10     /**< 送信エラー LinkMonitor が途絶を検出して停止させている */
+#define MOVE_ERR_DROPPED -11    /**< 送信エラー 待ち行列が満杯などで送れず，フレームを捨てた */
+
 
 /**
  * @brief 足回りモジュール操作クラス
  *
  *
  * 全方向移動機構を想定した足回りモジュールを操作するための抽象クラス @n
- * send() が純粋仮想関数である
+ * send() が純粋仮想関数である @n
+ * モジュールからオドメトリを受信する場合は recieve() もオーバーライドする
  *
- * @note すべての公開メソッドはそのまま通信を行うので割り込みなどには注意
- * @note すべての通信情報は 8byte である
+ * @note すべての公開メソッドはそのまま通信を行うので割り込みなどには注意 @n
+ *       割り込みから使用する場合は送信を FrameQueue に積む拡張クラスを使う
+ * @note すべての通信情報は 8byte である @n
+ *       モジュールからの受信フレームも送信と同じ形式で，8byte目が ODOM_POSE , ODOM_VELO , ODOM_STATUS になる
  *
  * @remarks 拡張クラスでデータ送受信を実装する必要がある
  *
@@ -38,6 +57,25 @@ class UnderBody
 {
 public:
 
+    /**
+     * モジュールから受信した情報 @n
+     * 時刻はすべて受信時の micros() [us] である
+     */
+    struct odometry{
+        long x;                 /**< 位置X [mm] */
+        long y;                 /**< 位置Y [mm] */
+        int theta;              /**< 姿勢 [0.1deg] */
+        int vX;                 /**< X方向の移動速度 [mm/s] */
+        int vY;                 /**< Y方向の移動速度 [mm/s] */
+        int omega;              /**< 旋回速度 [deg/s] */
+        unsigned int fault;     /**< 異常フラグ 0なら正常 */
+        unsigned int battery;   /**< 電源電圧 [10mV] */
+        unsigned long poseTime;     /**< 位置を受信した時刻 */
+        unsigned long veloTime;     /**< 速度を受信した時刻 */
+        unsigned long statusTime;   /**< 状態を受信した時刻 */
+        uint8_t valid;          /**< 受信済みの情報 ODOM_VALID_POSE , ODOM_VALID_VELO , ODOM_VALID_STATUS */
+    };
+
     /**
      * コンストラクタ
      * 
@@ -59,6 +97,8 @@ public:
      * @retval -4 vY指定が不正 最小値未満
      * @retval -5 omega指定が不正 最大値超過
      * @retval -6 omega指定が不正 最小値未満
+     * @retval MOVE_ERR_LOCKED LinkMonitor が途絶を検出して停止させている
+     * @retval MOVE_ERR_DROPPED 待ち行列が満杯などで送れなかった
      *
      * @note 引数はすべてint型である
      */
@@ -80,6 +120,8 @@ public:
      * @retval -4 vY指定が不正 最小値未満
      * @retval -5 omega指定が不正 最大値超過
      * @retval -6 omega指定が不正 最小値未満
+     * @retval MOVE_ERR_LOCKED LinkMonitor が途絶を検出して停止させている
+     * @retval MOVE_ERR_DROPPED 待ち行列が満杯などで送れなかった
      *
      * @note 引数はすべてdouble型である
      *
@@ -100,6 +142,8 @@ public:
      * @retval -2 spd指定が不正 最小値未満
      * @retval -3 omega指定が不正 最大値超過
      * @retval -4 omega指定が不正 最小値未満
+     * @retval MOVE_ERR_LOCKED LinkMonitor が途絶を検出して停止させている
+     * @retval MOVE_ERR_DROPPED 待ち行列が満杯などで送れなかった
      *
      * @note 引数はすべてint型である
      */
@@ -118,6 +162,8 @@ public:
      * @retval -2 spd指定が不正 最小値未満
      * @retval -3 omega指定が不正 最大値超過
      * @retval -4 omega指定が不正 最小値未満
+     * @retval MOVE_ERR_LOCKED LinkMonitor が途絶を検出して停止させている
+     * @retval MOVE_ERR_DROPPED 待ち行列が満杯などで送れなかった
      *
      * @note 引数はすべてdouble型である
      *
@@ -125,10 +171,152 @@ public:
      */
     int movePolar(double spd, double dir, double omega);
 
+    /**
+     * フィールド座標系として移動速度を与える．
+     * 機体の姿勢 heading を使ってロボット座標系に回転してから moveXY() で送る．
+     *
+     * @param vX フィールドX方向の移動速度 @p -8000 ~ @p 8000 [mm/s]
+     * @param vY フィールドY方向の移動速度 @p -8000 ~ @p 8000 [mm/s]
+     * @param omega 機体の旋回速度 @p -500 ~ @p 500 [deg/s]
+     * @param heading 機体の姿勢 [0.1deg] 反時計回りが正 UnderBody::odometry::theta と同じ単位 @n
+     *                int の範囲のどの値でもよい
+     *
+     * @retval 0 正常
+     * @retval -1 vX指定が不正 最大値超過
+     * @retval -2 vX指定が不正 最小値未満
+     * @retval -3 vY指定が不正 最大値超過
+     * @retval -4 vY指定が不正 最小値未満
+     * @retval -5 omega指定が不正 最大値超過
+     * @retval -6 omega指定が不正 最小値未満
+     * @retval MOVE_ERR_LOCKED LinkMonitor が途絶を検出して停止させている
+     * @retval MOVE_ERR_DROPPED 待ち行列が満杯などで送れなかった
+     *
+     * @note 回転後の速度が MAX_VELO を超える場合は，向きを保って MAX_VELO に収める
+     * @note 座標変換は FastTrig の表引きで行う
+     */
+    int moveField(int vX, int vY, int omega, int heading);
+
+    /**
+     * フィールド座標系として移動速度を与える．
+     *
+     * @param vX フィールドX方向の移動速度 @p -8.0 ~ @p 8.0 [m/s]
+     * @param vY フィールドY方向の移動速度 @p -8.0 ~ @p 8.0 [m/s]
+     * @param omega 機体の旋回速度 @p -8.72 ~ @p 8.72 [rad/s]
+     * @param heading 機体の姿勢 [rad] 反時計回りが正
+     *
+     * @retval moveField(int,int,int,int) と同じ
+     *
+     * @note 引数はすべてdouble型である
+     *
+     * @overload
+     */
+    int moveField(double vX, double vY, double omega, double heading);
+
     /**
      * 動作を停止する．
+     *
+     * @retval 0 正常
+     * @retval MOVE_ERR_DROPPED 待ち行列が満杯などで送れなかった
+     */
+    int stop();
+
+    /**
+     * 通信を記録する BusRecorder を設定する
+     *
+     * @note    T_UnderBody では受信データは Transport::attachRecorder() で記録する
+     *
+     * @param _recorder 記録先 @n
+     *                  NULL を指定すると記録しない
+     */
+    void attachRecorder(BusRecorder *_recorder);
+
+    /**
+     * 通信を監視する LinkMonitor を設定する
+     *
+     * 設定すると recvData() で受信したフレームを ID LINK_ID_UNDERBODY として，
+     * 正しければ LinkMonitor::frameOk() ，壊れていれば LinkMonitor::frameError() で報告する
+     *
+     * @param _monitor  報告先 @n
+     *                  NULL を指定すると報告しない
+     */
+    void attachMonitor(LinkMonitor *_monitor);
+
+    /**
+     * 停止させる状態を設定する
+     *
+     * 停止させている間は stop() だけを送り， moveXY() などの移動の指令は送らずに MOVE_ERR_LOCKED を返す @n
+     * LinkMonitor が途絶を検出したときに設定し，復帰したときに解除する
+     *
+     * @param lock  @p true なら停止させる
+     */
+    void setFailsafe(bool lock);
+
+    /**
+     * @retval true     停止させている
+     * @retval false    通常
+     */
+    bool isFailsafe();
+
+    /**
+     * 受信データから情報を取り出し，メンバ変数に格納する
+     *
+     * @return 読み込んだデータ数
+     *
+     * @attention 同じモジュールの情報を取得する場合，1つのクラス実体だけで，このメソッドを呼び出すこと．
+     * @attention 同じシリアル通信を S_Fets なども受信していると，データを取り合うため正しく受信できない．
      */
-    void stop();
+    int recvData();
+
+    /**
+     * モジュールから受信した情報を取得する
+     *
+     * 例)
+     * @code
+     *  const UnderBody::odometry &odom = Omni4.getOdometry();
+     *
+     *  if(odom.valid & ODOM_VALID_POSE){
+     *      Serial.println(odom.x);
+     *  }
+     * @endcode
+     *
+     * @return 受信した情報
+     *
+     * @note    この関数内部で recvData() が実行されている
+     */
+    const odometry &getOdometry();
+
+    /**
+     * 送信フレーム(8byte)を作成する
+     *
+     * 各パラメータは符号1bitと絶対値13bitで，上位6bitと下位7bitの2byteに分けて格納する
+     *
+     * @param frame     フレームの格納先 8byte以上
+     * @param param1    送信パラメータ1 @p -8191 ~ @p 8191
+     * @param param2    送信パラメータ2 @p -8191 ~ @p 8191
+     * @param param3    送信パラメータ3 @p -8191 ~ @p 8191
+     * @param mode      モード @p MOVE_RECT,MOVE_POLAR,MOVE_STOP
+     *
+     * @return  フレームの長さ
+     *
+     * @note    範囲外のパラメータは範囲内に丸める
+     */
+    static int makeFrame(uint8_t *frame, int param1, int param2, int param3, uint8_t mode);
+
+    /**
+     * フレーム(8byte)を解読する makeFrame() の逆変換
+     *
+     * @param frame     フレーム
+     * @param param1    送信パラメータ1の格納先
+     * @param param2    送信パラメータ2の格納先
+     * @param param3    送信パラメータ3の格納先
+     * @param mode      モードの格納先
+     *
+     * @retval 0    正常
+     * @retval -1   パラメータの最上位bitが立っている
+     * @retval -2   チェックサムが不正
+     * @retval -3   モードが不正 最上位bitが立っていない
+     */
+    static int decodeFrame(const uint8_t *frame, int *param1, int *param2, int *param3, uint8_t *mode);
 
 protected:
 
@@ -140,8 +328,12 @@ protected:
      * @param param2    送信パラメータ2
      * @param param3    送信パラメータ3
      * @param mode      モード @p MOVE_RECT,MOVE_POLAR,MOVE_STOP
+     *
+     * @retval 0                正常
+     * @retval MOVE_ERR_LOCKED  停止させている MOVE_STOP 以外は送らない
+     * @retval MOVE_ERR_DROPPED sendFrame() がフレームを捨てた
      */
-    void sendData(int param1, int param2, int param3, uint8_t mode);
+    int sendData(int param1, int param2, int param3, uint8_t mode);
 
     /**
      * データを送信する関数 @n
@@ -153,8 +345,73 @@ protected:
      */
     virtual void send(char data) = 0;
 
+    /**
+     * フレームをまとめて送信する関数 @n
+     * 外部呼び出しはされない
+     *
+     * 標準では send() を1byteずつ呼び出す @n
+     * 拡張クラスでオーバーライドすると，まとめて書き込んだり待ち行列に積んだりできる
+     *
+     * @param frame 送信するフレーム
+     * @param len   フレームの長さ
+     *
+     * @retval true     送信した，または待ち行列に積んだ
+     * @retval false    待ち行列が満杯などで捨てた
+     */
+    virtual bool sendFrame(const uint8_t *frame, int len);
+
+    /**
+     * 受信データを返す関数 @n
+     * 外部呼び出しはされない
+     *
+     * 標準では受信しない 受信する場合は拡張クラスでオーバーライドする
+     *
+     * @retval -1 新規データなし @n
+     * @retval 0~0xFF 受信したデータ
+     */
+    virtual int recieve();
+
+    /**
+     * 受信データを1byte解析し，正しい受信フレームがそろえば情報を取り出す @n
+     * recvData() が recieve() で読んだ1byteごとに呼び出す
+     *
+     * 受信を Transport などで別に行う拡張クラスは，受信した1byteごとにこの関数を呼び出す
+     *
+     * @param data  受信したデータ
+     */
+    void parseByte(uint8_t data);
+
 private:
 
+    /**
+     * 正しい受信フレームから情報を取り出す
+     */
+    void updateOdometry();
+
+    /**
+     * 通信の記録先
+     */
+    BusRecorder *recorder;
+
+    /**
+     * 通信の監視先
+     */
+    LinkMonitor *monitor;
+
+    /**
+     * 停止させている
+     */
+    bool failsafe;
+
+    /**
+     * 受信情報の配列
+     */
+    uint8_t dataBuff[8];
+
+    /**
+     * 受信した情報
+     */
+    odometry odom;
 };
 
 #endif
\ No newline at end of file
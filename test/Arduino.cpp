@@ -0,0 +1,45 @@
+/**
+ * @file test/Arduino.cpp
+ * @brief ホスト用 Arduino API の代用品の実装
+ */
+
+#include "Arduino.h"
+
+
+unsigned long hostMicros = 0;
+int hostAnalog[32];
+int hostPin[64];
+
+HardwareSerial Serial, Serial1, Serial2, Serial3;
+
+unsigned long micros(){ return hostMicros; }
+unsigned long millis(){ return hostMicros / 1000; }
+void delay(unsigned long ms){ hostMicros += ms * 1000; }
+void delayMicroseconds(unsigned int us){ hostMicros += us; }
+int analogRead(int pin){ hostMicros += 20; return hostAnalog[pin & 31]; }
+void analogReference(int){}
+void pinMode(int, int){}
+void digitalWrite(int pin, int value){ hostPin[pin & 63] = value; }
+void noInterrupts(){}
+void interrupts(){}
+
+size_t Print::write(const uint8_t *buff, size_t len){
+    for(size_t i=0; i<len; i++){
+        write(buff[i]);
+    }
+    return len;
+}
+
+size_t Print::print(long value){
+    char str[24];
+
+    sprintf(str, "%ld", value);
+    return print(str);
+}
+
+size_t Print::print(unsigned long value){
+    char str[24];
+
+    sprintf(str, "%lu", value);
+    return print(str);
+}
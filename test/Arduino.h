@@ -0,0 +1,87 @@
+/**
+ * @file test/Arduino.h
+ * @brief ホストでテストするための Arduino API の代用品
+ *
+ * ライブラリが使う関数と定数だけを用意する @n
+ * 時刻は hostMicros を書き換えて進める
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PI 3.1415926535897932384626433832795
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define A0 14
+#define A1 15
+#define A2 16
+#define RAW12BIT 3
+#define PIN_LED0 10
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+extern unsigned long hostMicros;    /**< micros() の値 テストが進める */
+extern int hostAnalog[32];          /**< analogRead() の値 */
+extern int hostPin[64];             /**< digitalWrite() の値 */
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+int analogRead(int pin);
+void analogReference(int type);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+void noInterrupts();
+void interrupts();
+
+class Print
+{
+public:
+    virtual ~Print(){}
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t *buff, size_t len);
+    size_t write(char data){ return write((uint8_t)data); }
+    size_t print(const char *str){ return write((const uint8_t *)str, strlen(str)); }
+    size_t print(int value){ return print((long)value); }
+    size_t print(unsigned int value){ return print((unsigned long)value); }
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t println(){ return print("\r\n"); }
+    size_t println(const char *str){ return print(str) + println(); }
+    size_t println(int value){ return print(value) + println(); }
+    size_t println(long value){ return print(value) + println(); }
+};
+
+/**
+ * 受信データは rx に入れ，送信データは tx にたまる
+ */
+class HardwareSerial : public Print
+{
+public:
+    HardwareSerial(){ rxLen = rxPos = txLen = 0; }
+    void begin(long){}
+    void flush(){}
+    int available(){ return rxLen - rxPos; }
+    int read(){ return (rxPos < rxLen) ? rx[rxPos++] : -1; }
+    size_t write(uint8_t data){ if(txLen < (int)sizeof(tx)) tx[txLen++] = data; return 1; }
+    using Print::write;
+
+    uint8_t rx[256], tx[256];
+    int rxLen, rxPos, txLen;
+};
+
+extern HardwareSerial Serial, Serial1, Serial2, Serial3;
+
+#endif
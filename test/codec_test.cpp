@@ -0,0 +1,363 @@
+/**
+ * @file test/codec_test.cpp
+ * @brief フレームの作成/解読と受信処理のホスト用テスト
+ *
+ *  -# UnderBody::makeFrame() , decodeFrame() の往復 (飽和を含む)
+ *  -# Fets::makeFrame() , makeFrameEx() , decodeFrame() の全値での往復
+ *  -# 壊れたデータ，ずれたデータを Fets::parseByte() , UnderBody::parseByte() に流し，
+ *     正しいフレームのときだけ状態が変わることを確認する
+ *  -# 従来の API は 4byte のフレームだけを送り，拡張フレームは writeDuty() , writeWaveFine() だけが送ることを確認する
+ *  -# UnderBody::moveField() の姿勢が int の端の値でも正しく回転することを確認する
+ */
+
+#include <Arduino.h>
+#include <limits.h>
+
+#include "../Fets.h"
+#include "../UnderBody.h"
+
+
+static unsigned long failed = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ if(failed++ < 20) printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); } }while(0)
+
+
+/*
+ * 再現できる乱数 (xorshift32)
+ */
+static uint32_t seed = 0x12345678;
+
+static uint32_t rnd(){
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+
+/*
+ * parseByte() を外から呼べるようにした実装
+ */
+class HostFets : public Fets
+{
+public:
+    HostFets(char _id) : Fets(_id){ lastLen = 0; }
+    void feed(uint8_t data){ parseByte(data); }
+
+    int lastLen;
+protected:
+    void send(char){}
+    int recieve(){ return -1; }
+    bool sendFrame(const uint8_t *, int len){ lastLen = len; return true; }
+};
+
+class HostUnderBody : public UnderBody
+{
+public:
+    HostUnderBody(){ memset(last, 0, sizeof(last)); }
+    void feed(uint8_t data){ parseByte(data); }
+
+    uint8_t last[8];
+protected:
+    void send(char){}
+    bool sendFrame(const uint8_t *frame, int len){ memcpy(last, frame, len); return true; }
+};
+
+
+static void testUnderBodyRoundTrip(){
+    uint8_t frame[8];
+    int p1, p2, p3;
+    uint8_t mode;
+
+    for(int p=-8191; p<=8191; p++){
+        CHECK(UnderBody::makeFrame(frame, p, -p, p/3, MOVE_RECT) == 8);
+        CHECK(UnderBody::decodeFrame(frame, &p1, &p2, &p3, &mode) == 0);
+        CHECK(p1 == p && p2 == -p && p3 == p/3 && mode == MOVE_RECT);
+    }
+
+    const int over[] = {8192, 8193, 10000, 32767, -8192, -10000, -32768};
+    for(unsigned i=0; i<sizeof(over)/sizeof(over[0]); i++){
+        UnderBody::makeFrame(frame, over[i], over[i], over[i], MOVE_POLAR);
+        CHECK(UnderBody::decodeFrame(frame, &p1, &p2, &p3, &mode) == 0);
+        CHECK(p1 == (over[i] > 0 ? 8191 : -8191) && p1 == p2 && p2 == p3);
+    }
+
+    const uint8_t modes[] = {MOVE_RECT, MOVE_POLAR, MOVE_STOP, ODOM_POSE, ODOM_VELO, ODOM_STATUS};
+    for(int n=0; n<100000; n++){
+        int q1 = (int)(rnd() % 20001) - 10000;
+        int q2 = (int)(rnd() % 20001) - 10000;
+        int q3 = (int)(rnd() % 20001) - 10000;
+        uint8_t m = modes[rnd() % 6];
+
+        UnderBody::makeFrame(frame, q1, q2, q3, m);
+        CHECK(UnderBody::decodeFrame(frame, &p1, &p2, &p3, &mode) == 0);
+        CHECK(p1 == constrain(q1, -8191, 8191) && p2 == constrain(q2, -8191, 8191) && p3 == constrain(q3, -8191, 8191));
+        CHECK(mode == m);
+    }
+
+    for(int n=0; n<1000000; n++){      // 任意のデータ 解読できたら作り直して同じになる
+        uint8_t again[8];
+
+        for(int i=0; i<8; i++) frame[i] = (uint8_t)rnd();
+        if(n & 1){
+            for(int i=0; i<6; i++) frame[i] &= 0x7F;
+            frame[6] = frame[0] ^ frame[1] ^ frame[2] ^ frame[3] ^ frame[4] ^ frame[5];
+        }
+
+        if(UnderBody::decodeFrame(frame, &p1, &p2, &p3, &mode) != 0) continue;
+
+        CHECK(p1 >= -8191 && p1 <= 8191 && p2 >= -8191 && p2 <= 8191 && p3 >= -8191 && p3 <= 8191);
+
+        UnderBody::makeFrame(again, p1, p2, p3, mode);
+        for(int i=0; i<3; i++){
+            if(p1 == 0 && i == 0) frame[0] &= ~0x40;    // -0 は +0 になる
+            if(p2 == 0 && i == 1) frame[2] &= ~0x40;
+            if(p3 == 0 && i == 2) frame[4] &= ~0x40;
+        }
+        frame[6] = frame[0] ^ frame[1] ^ frame[2] ^ frame[3] ^ frame[4] ^ frame[5];
+        CHECK(memcmp(frame, again, 8) == 0);
+    }
+}
+
+static void testFetsRoundTrip(){
+    uint8_t frame[6];
+    uint8_t funcBit;
+    Fets::portNum port;
+    uint16_t parameter;
+    char id;
+
+    for(int func=0; func<16; func++){
+        if(func == FUNC_EXTENDED) continue;
+
+        for(int op=0; op<8; op++){
+            for(int param=0; param<128; param++){
+                for(int i=0x80; i<0x100; i+=0x0F){
+                    CHECK(Fets::makeFrame(frame, (uint8_t)func, (Fets::portNum)op, (uint8_t)param, (char)i) == 4);
+                    CHECK(Fets::decodeFrame(frame, 4, &funcBit, &port, &parameter, &id) == 4);
+                    CHECK(funcBit == func && port == op && parameter == param && (uint8_t)id == i);
+                    CHECK(Fets::isStateFrame(frame, (char)i));
+                }
+            }
+        }
+    }
+
+    for(int func=0; func<128; func++){
+        for(int op=0; op<8; op++){
+            for(int param=0; param<=0x3FFF; param++){
+                CHECK(Fets::makeFrameEx(frame, (uint8_t)func, (Fets::portNum)op, (uint16_t)param, (char)DEF_ID) == 6);
+                if(Fets::decodeFrame(frame, 6, &funcBit, &port, &parameter, &id) != 6
+                   || funcBit != func || port != op || parameter != param || (uint8_t)id != DEF_ID){
+                    CHECK(false);
+                }
+            }
+        }
+    }
+
+    CHECK(Fets::decodeFrame(frame, 5, &funcBit, &port, &parameter, &id) == -1);    // 拡張フレームが途中まで
+
+    for(int duty=0; duty<=MAX_DUTY; duty++){
+        uint8_t compact;
+
+        if(Fets::compactDuty((uint16_t)duty, &compact)){
+            CHECK(compact <= 127);
+            CHECK((compact*(unsigned long)MAX_DUTY + 63) / 127 == (unsigned long)duty);
+        }
+    }
+    for(int period=100; period<=10000; period++){
+        uint8_t compact;
+
+        CHECK(Fets::compactPeriod(period, &compact) == (period % 100 == 0));
+    }
+
+    for(int n=0; n<1000000; n++){      // 任意のデータ 解読できたら作り直して同じになる
+        uint8_t again[6];
+        int len = (n & 1) ? 6 : 4;
+        int got;
+
+        for(int i=0; i<6; i++) frame[i] = (uint8_t)rnd();
+        if(n & 2) frame[0] = (frame[0] & 0x07) | (FUNC_EXTENDED << 3);
+
+        if((got = Fets::decodeFrame(frame, len, &funcBit, &port, &parameter, &id)) < 0) continue;
+
+        if(got == 4){
+            Fets::makeFrame(again, funcBit, port, (uint8_t)parameter, id);
+        }
+        else{
+            CHECK(parameter <= 0x3FFF && funcBit <= 0x7F);
+            Fets::makeFrameEx(again, funcBit, port, parameter, id);
+        }
+        CHECK(memcmp(frame, again, got) == 0);
+    }
+}
+
+static void testFetsParser(){
+    const char id = (char)0x91;
+    HostFets module(id);
+    uint8_t window[4] = {};
+    int input = module.getInputState(), output = module.getOutputState();
+
+    for(int n=0; n<200000; n++){
+        uint8_t chunk[8];
+        int len = 0;
+        int kind = rnd() % 6;
+        uint8_t in = rnd() & 0x7F, out = rnd() & 0x7F;
+
+        chunk[len++] = in;
+        chunk[len++] = out;
+        chunk[len++] = in ^ out;
+        chunk[len++] = (uint8_t)id;
+
+        switch(kind){
+        case 0: break;                                      // 正しい状態通知
+        case 1: chunk[rnd() % 4] ^= 1 << (rnd() % 8); break; // 1bit 化け
+        case 2: len = 1 + rnd() % 3; break;                 // 途中で切れた
+        case 3: chunk[3] = 0x90; break;                     // 別のモジュール
+        case 4: chunk[0] = (uint8_t)rnd(); len = 1; break;  // ごみ
+        case 5: chunk[2] ^= 0x01; break;                    // チェックサム不正
+        }
+
+        for(int i=0; i<len; i++){
+            module.feed(chunk[i]);
+
+            window[0] = window[1]; window[1] = window[2]; window[2] = window[3]; window[3] = chunk[i];
+
+            int newInput = module.getInputState(), newOutput = module.getOutputState();
+            bool valid = window[3] == (uint8_t)id && window[2] == (window[0] ^ window[1]);
+
+            if(newInput != input || newOutput != output){
+                CHECK(valid);
+            }
+            if(valid){
+                CHECK(newInput == window[0] && newOutput == window[1]);
+            }
+            input = newInput;
+            output = newOutput;
+        }
+
+        if(kind == 0){
+            CHECK(input == in && output == out);
+        }
+    }
+}
+
+static void testUnderBodyParser(){
+    HostUnderBody body;
+    uint8_t window[8] = {};
+    UnderBody::odometry last = body.getOdometry();
+
+    for(int n=0; n<200000; n++){
+        uint8_t chunk[8];
+        int len = 8;
+        int kind = rnd() % 6;
+        int q1 = (int)(rnd() % 16383) - 8191, q2 = (int)(rnd() % 16383) - 8191, q3 = (int)(rnd() % 16383) - 8191;
+        uint8_t type = ODOM_POSE + rnd() % 3;
+
+        UnderBody::makeFrame(chunk, q1, q2, q3, type);
+
+        switch(kind){
+        case 0: break;                                      // 正しいフレーム
+        case 1: chunk[rnd() % 7] ^= 1 << (rnd() % 8); break; // 1bit 化け
+        case 2: len = 1 + rnd() % 7; break;                 // 途中で切れた
+        case 3: chunk[7] = MOVE_RECT; break;                // 送信フレームのこだま
+        case 4: chunk[0] = (uint8_t)rnd(); len = 1; break;  // ごみ
+        case 5: chunk[6] ^= 0x01; break;                    // チェックサム不正
+        }
+
+        for(int i=0; i<len; i++){
+            hostMicros++;
+            body.feed(chunk[i]);
+
+            memmove(window, window + 1, 7);
+            window[7] = chunk[i];
+
+            const UnderBody::odometry &odom = body.getOdometry();
+            int p1, p2, p3;
+            uint8_t mode;
+            bool valid = window[7] >= ODOM_POSE && window[7] <= ODOM_STATUS
+                      && UnderBody::decodeFrame(window, &p1, &p2, &p3, &mode) == 0;
+
+            if(memcmp(&odom, &last, sizeof(odom)) != 0){
+                CHECK(valid);
+            }
+            if(valid){
+                switch(mode){
+                case ODOM_POSE:
+                    CHECK(odom.x == (long)p1 * ODOM_POS_UNIT && odom.y == (long)p2 * ODOM_POS_UNIT && odom.theta == p3);
+                    CHECK(odom.poseTime == hostMicros);
+                    break;
+                case ODOM_VELO:
+                    CHECK(odom.vX == p1 && odom.vY == p2 && odom.omega == p3);
+                    CHECK(odom.veloTime == hostMicros);
+                    break;
+                case ODOM_STATUS:
+                    CHECK(odom.fault == (unsigned)p1 && odom.battery == (unsigned)p2);
+                    CHECK(odom.statusTime == hostMicros);
+                    break;
+                }
+            }
+            last = odom;
+        }
+
+        if(kind == 0){
+            CHECK(type != ODOM_VELO || (last.vX == q1 && last.vY == q2 && last.omega == q3));
+        }
+    }
+}
+
+static void testFetsFrameSize(){
+    HostFets Fet(DEF_ID);
+
+    for(int period=100; period<=10000; period++){
+        CHECK(Fet.writeWave(Fets::Sine, period, Fets::Out1) == 0);
+        CHECK(Fet.lastLen == 4);
+        CHECK(Fet.writeWaveFine(Fets::Sine, period, Fets::Out1) == 0);
+        CHECK(Fet.lastLen == (period % 100 == 0 ? 4 : 6));
+    }
+    CHECK(Fet.writeWaveFine(Fets::Sine, 99, Fets::Out1) == -3);
+    CHECK(Fet.writeWaveFine(Fets::Sine, 10001, Fets::Out1) == -4);
+    CHECK(Fet.writeWaveFine(Fets::Sine, 500, Fets::Out7) == -2);
+
+    for(int n=0; n<=1000; n++){
+        CHECK(Fet.write(n / 1000.0, Fets::Out2) == 0);
+        CHECK(Fet.lastLen == 4);
+    }
+}
+
+static void testMoveFieldHeading(){
+    HostUnderBody Body;
+    int x, y, omega, ref[2];
+    uint8_t mode;
+
+    const int heading[] = {INT_MIN, INT_MIN + 1, INT_MAX, -3600 * 9102, 3600 * 9102 + 900};
+
+    for(unsigned i=0; i<sizeof(heading)/sizeof(heading[0]); i++){
+        CHECK(Body.moveField(1000, 0, 0, heading[i] % 3600) == 0);
+        UnderBody::decodeFrame(Body.last, &ref[0], &ref[1], &omega, &mode);
+
+        CHECK(Body.moveField(1000, 0, 0, heading[i]) == 0);
+        CHECK(UnderBody::decodeFrame(Body.last, &x, &y, &omega, &mode) == 0);
+        CHECK(x == ref[0] && y == ref[1] && mode == MOVE_RECT);
+    }
+
+    CHECK(Body.moveField(1000, 0, 0, 900 + 3600 * 5) == 0);      // 90deg 向いていれば機体の -Y 方向
+    UnderBody::decodeFrame(Body.last, &x, &y, &omega, &mode);
+    CHECK(abs(x) <= 1 && y == -1000);
+}
+
+
+int main(){
+    testUnderBodyRoundTrip();
+    testFetsRoundTrip();
+    testFetsParser();
+    testUnderBodyParser();
+    testFetsFrameSize();
+    testMoveFieldHeading();
+
+    if(failed){
+        printf("codec_test: %lu checks failed\n", failed);
+        return 1;
+    }
+
+    printf("codec_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,336 @@
+/**
+ * @file test/failsafe_test.cpp
+ * @brief 通信途絶時の停止のホスト用テスト
+ *
+ *  -# LinkMonitor が途絶を検出すると stop() , allOff() を送り，
+ *     途絶している間は移動と出力の指令を送らないことを確認する
+ *  -# 正しいフレームを受信して復帰すると，指令を送れるようになることを確認する
+ *  -# PoseController が古い位置・姿勢で制御せず，停止を送ることを確認する
+ *  -# 待ち行列が満杯で送れなかったとき，メソッドがエラーを返すことを確認する
+ *  -# CommandScheduler が満杯のとき，捨てたフレームと積めなかったフレームを分けて数えることを確認する
+ *  -# FetPort が Fets の実体と同じ経路で送受信することを確認する
+ */
+
+#include <Arduino.h>
+
+#include "../Fets.h"
+#include "../FetPort.h"
+#include "../UnderBody.h"
+#include "../LinkMonitor.h"
+#include "../PoseController.h"
+#include "../Transport.h"
+#include "../CommandScheduler.h"
+
+
+static unsigned long failed = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ if(failed++ < 20) printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); } }while(0)
+
+
+/*
+ * 送信したフレームを数え，最後のフレームを残す実装
+ */
+class HostFets : public Fets
+{
+public:
+    HostFets(char _id) : Fets(_id){ sent = 0; }
+    void feed(uint8_t data){ parseByte(data); }
+
+    int sent;
+protected:
+    void send(char){}
+    int recieve(){ return -1; }
+    bool sendFrame(const uint8_t *, int){ sent++; return true; }
+};
+
+class HostUnderBody : public UnderBody
+{
+public:
+    HostUnderBody(){ sent = 0; lastMode = 0; lastX = 0; }
+    void feed(uint8_t data){ parseByte(data); }
+
+    int sent;
+    uint8_t lastMode;
+    int lastX;
+protected:
+    void send(char){}
+    bool sendFrame(const uint8_t *frame, int){
+        int p2, p3;
+
+        sent++;
+        decodeFrame(frame, &lastX, &p2, &p3, &lastMode);
+        return true;
+    }
+};
+
+
+static void feedState(HostFets &fet){
+    const uint8_t frame[4] = {0x00, 0x00, 0x00, DEF_ID};
+
+    for(int i=0; i<4; i++) fet.feed(frame[i]);
+}
+
+static void feedOdometry(HostUnderBody &body){
+    uint8_t frame[8];
+
+    UnderBody::makeFrame(frame, 0, 0, 0, ODOM_VELO);
+    for(int i=0; i<8; i++) body.feed(frame[i]);
+}
+
+
+static void testLatch(){
+    HostFets Fet(DEF_ID);
+    HostUnderBody Body;
+    LinkMonitor Monitor;
+
+    hostMicros = 1000000;
+
+    Fet.attachMonitor(&Monitor);
+    Body.attachMonitor(&Monitor);
+    CHECK(Monitor.watch(LINK_ID_UNDERBODY, 100, LINK_ACT_STOP) == 0);
+    CHECK(Monitor.watch(DEF_ID, 100, LINK_ACT_FET_OFF) == 0);
+    CHECK(Monitor.addFailsafe(&Body) == 0);
+    CHECK(Monitor.addFailsafe(&Fet) == 0);
+
+    feedState(Fet);
+    feedOdometry(Body);
+    CHECK(Monitor.update() == 0);
+    CHECK(Body.moveXY(100, 0, 0) == 0);
+    CHECK(Fet.write(1, Fets::Out1) == 0);
+
+    // 足回りだけ途絶する
+    hostMicros += 150000;
+    feedState(Fet);
+    Body.sent = 0;
+    Fet.sent = 0;
+    CHECK(Monitor.update() == 1);
+    CHECK(Monitor.getState(LINK_ID_UNDERBODY) == LINK_OFFLINE);
+    CHECK(Body.sent == 1 && Body.lastMode == MOVE_STOP);
+    CHECK(Body.isFailsafe() && !Fet.isFailsafe());
+    CHECK(Fet.sent == 0);
+
+    // 途絶している間は次の周期の指令も送らない
+    for(int k=0; k<5; k++){
+        hostMicros += 10000;
+        feedState(Fet);
+        CHECK(Body.moveXY(100, 0, 0) == MOVE_ERR_LOCKED);
+        CHECK(Body.movePolar(100, 0, 0) == MOVE_ERR_LOCKED);
+        CHECK(Body.moveField(100, 0, 0, 0) == MOVE_ERR_LOCKED);
+        CHECK(Fet.write(1, Fets::Out1) == 0);
+        Monitor.update();
+    }
+    CHECK(Body.sent == 1);
+    Body.stop();
+    CHECK(Body.sent == 2 && Body.lastMode == MOVE_STOP);
+
+    // FETモジュールも途絶すると出力を切り，出力を切る指令だけを送る
+    hostMicros += 150000;
+    Fet.sent = 0;
+    CHECK(Monitor.update() == 2);
+    CHECK(Fet.isFailsafe());
+    CHECK(Fet.sent == 13);
+    CHECK(Fet.write(1, Fets::Out1) == FET_ERR_LOCKED);
+    CHECK(Fet.write(0.5, Fets::Out2) == FET_ERR_LOCKED);
+    CHECK(Fet.writeWave(Fets::Square, 500, Fets::Out2) == FET_ERR_LOCKED);
+    CHECK(Fet.startPattern(true, 0, Fets::Out2) == FET_ERR_LOCKED);
+    CHECK(Fet.sent == 13);
+    CHECK(Fet.write(0, Fets::Out1) == 0);
+    CHECK(Fet.stopPattern(Fets::Out2) == 0);
+    CHECK(Fet.sent == 15);
+
+    // 足回りが復帰しても，FETモジュールの停止は保持する
+    feedOdometry(Body);
+    CHECK(Monitor.getState(LINK_ID_UNDERBODY) == LINK_OK);
+    CHECK(!Body.isFailsafe() && Fet.isFailsafe());
+    CHECK(Body.moveXY(100, 0, 0) == 0);
+    CHECK(Fet.write(1, Fets::Out1) == FET_ERR_LOCKED);
+
+    feedState(Fet);
+    CHECK(!Fet.isFailsafe());
+    CHECK(Fet.write(1, Fets::Out1) == 0);
+    CHECK(Monitor.update() == 0);
+}
+
+static void feedPose(HostUnderBody &body, int x){
+    uint8_t frame[8];
+
+    UnderBody::makeFrame(frame, x / ODOM_POS_UNIT, 0, 0, ODOM_POSE);
+    for(int i=0; i<8; i++) body.feed(frame[i]);
+}
+
+static void testStalePose(){
+    HostUnderBody Body;
+
+    hostMicros = 1000000;
+
+    PoseController Pose(&Body, 10);
+    Pose.useOdometry(true);
+    Pose.setTarget(1000, 0, 0);
+
+    // 位置が無い間は止める
+    hostMicros += 10000;
+    CHECK(Pose.update() == -1);
+    CHECK(Body.sent == 1 && Body.lastMode == MOVE_STOP);
+
+    // 受信している間は制御する
+    for(int k=0; k<5; k++){
+        hostMicros += 10000;
+        feedPose(Body, 100 * k);
+        CHECK(Pose.update() == 1);
+        CHECK(Body.lastMode == MOVE_RECT && Body.lastX > 0);
+    }
+
+    // 途絶すると有効時間の後は止め続ける
+    int sent = Body.sent;
+    for(int k=1; k<=20; k++){
+        hostMicros += 10000;
+        int ret = Pose.update();
+
+        if(k * 10 < POSE_TIMEOUT){
+            CHECK(ret == 1 && Body.lastMode == MOVE_RECT);
+        }
+        else{
+            CHECK(ret == -1 && Body.lastMode == MOVE_STOP);
+        }
+    }
+    CHECK(Body.sent == sent + 20);
+    CHECK(!Pose.reached(10000, 3600));
+
+    // 受信が戻れば制御を再開する
+    hostMicros += 10000;
+    feedPose(Body, 500);
+    CHECK(Pose.update() == 1 && Body.lastMode == MOVE_RECT);
+    CHECK(Pose.reached(10000, 3600));
+
+    // setPose() も同じく古さを確認し， 0 なら確認しない
+    Pose.useOdometry(false);
+    Pose.setPose(0, 0, 0);
+    hostMicros += POSE_TIMEOUT * 1000UL;
+    CHECK(Pose.update() == -1 && Body.lastMode == MOVE_STOP);
+    Pose.setTimeout(0);
+    hostMicros += 10000;
+    CHECK(Pose.update() == 1 && Body.lastMode == MOVE_RECT);
+}
+
+static void testQueueFull(){
+    LoopbackTransport Master, Module;
+    FrameQueue Queue;
+    T_Fets Fet(&Master);
+    T_UnderBody Body(&Master);
+    int num = 0;
+
+    Master.connect(&Module);
+    Fet.setQueue(&Queue);
+    Body.setQueue(&Queue);
+
+    while(Fet.write(1, Fets::Out1) == 0) num++;
+    CHECK(num == FRAME_QUEUE_SIZE - 1);
+    CHECK(Queue.getDropped() == 1);
+    CHECK(Fet.write(1, Fets::Out1) == FET_ERR_DROPPED);
+    CHECK(Fet.allOff() == FET_ERR_DROPPED);
+    CHECK(Body.moveXY(100, 0, 0) == MOVE_ERR_DROPPED);
+    CHECK(Body.stop() == MOVE_ERR_DROPPED);
+
+    // 待ち行列を通信路に送ると，また積める
+    CHECK(Queue.drain(&Module, 4) == 4);
+    CHECK(Queue.drain(&Master, 4) == 4);
+    CHECK(Body.stop() == 0);
+    CHECK(Fet.write(0, Fets::Out1) == 0);
+
+    // 通信路が受け付けなかったフレームは数えない
+    Master.connect(NULL);
+    CHECK(Queue.drain(&Master) == 0);
+    CHECK(Queue.count() == 0);
+    Fet.setQueue(NULL);
+    CHECK(Fet.write(0, Fets::Out1) == FET_ERR_DROPPED);
+}
+
+static void testSchedulerFull(){
+    LoopbackTransport Master, Module;
+    CommandScheduler Sched(&Master);
+    uint8_t frame[4];
+    int num = 0;
+
+    Master.connect(&Module);
+    Fets::makeFrame(frame, FUNC_DIGITAL_OUT, Fets::Out1, 1, DEF_ID);
+
+    while(Sched.post(frame, 4, SCHED_PRIO_LOW) == 0) num++;
+    CHECK(num == SCHED_QUEUE_SIZE);
+    CHECK(Sched.getStats().rejected == 1 && Sched.getStats().evicted == 0);
+
+    // 優先度の高いフレームは低いフレームを捨てて積む
+    CHECK(Sched.post(frame, 4, SCHED_PRIO_HIGH) == 0);
+    CHECK(Sched.post(frame, 4, SCHED_PRIO_HIGH) == 0);
+    CHECK(Sched.post(frame, 4, SCHED_PRIO_LOW) == -2);
+    CHECK(Sched.count() == SCHED_QUEUE_SIZE);
+
+    const CommandScheduler::stats &st = Sched.getStats();
+    CHECK(st.evicted == 2);
+    CHECK(st.rejected == 2);
+    CHECK(st.expired == 0);
+    CHECK(st.dropped == st.evicted + st.rejected + st.expired);
+
+    Sched.clearStats();
+    CHECK(Sched.getStats().dropped == 0 && Sched.getStats().evicted == 0 && Sched.getStats().rejected == 0);
+}
+
+static void testFetPort(){
+    HostFets Fet(DEF_ID);
+    LinkMonitor Monitor;
+    FetPort<Fets::Out2, Fets::In1> Lamp(Fet);
+
+    hostMicros = 1000000;
+
+    // 受信した状態は Fets の実体と共有する
+    const uint8_t frame[4] = {0x01, 0x02, 0x03, DEF_ID};
+    for(int i=0; i<4; i++) Fet.feed(frame[i]);
+    CHECK(Lamp.getOutputState() == 1 && Fet.getOutputState(Fets::Out2) == 1);
+    CHECK(Lamp.getInputState() == 1 && Lamp.getInputState(Fets::In2) == 0);
+
+    CHECK(Lamp.write(1) == 0);
+    CHECK(Lamp.writeWave(Fets::Square, 500) == 0);
+    CHECK(Lamp.sensorResponce(1, 1) == 1);
+    CHECK(Fet.sent == 3);
+
+    // 途絶して出力を止めている間は Fets と同じく送らない
+    Fet.attachMonitor(&Monitor);
+    CHECK(Monitor.watch(DEF_ID, 100, LINK_ACT_FET_OFF) == 0);
+    CHECK(Monitor.addFailsafe(&Fet) == 0);
+    feedState(Fet);
+    hostMicros += 150000;
+    CHECK(Monitor.update() == 1);
+    Fet.sent = 0;
+    CHECK(Lamp.write(1) == FET_ERR_LOCKED);
+    CHECK(Lamp.write(0.5) == FET_ERR_LOCKED);
+    CHECK(Lamp.writeDuty(100) == FET_ERR_LOCKED);
+    CHECK(Lamp.write(0) == 0);
+    CHECK(Fet.sent == 1);
+
+    // 待ち行列が満杯なら FET_ERR_DROPPED を返す
+    LoopbackTransport Master;
+    FrameQueue Queue;
+    T_Fets TFet(&Master);
+    FetPort<Fets::Out1> Valve(TFet);
+
+    TFet.setQueue(&Queue);
+    while(Valve.write(1) == 0);
+    CHECK(Valve.write(1) == FET_ERR_DROPPED);
+    CHECK(Queue.count() == FRAME_QUEUE_SIZE - 1);
+}
+
+
+int main(){
+    testLatch();
+    testStalePose();
+    testQueueFull();
+    testSchedulerFull();
+    testFetPort();
+
+    if(failed){
+        printf("failsafe_test: %lu checks failed\n", failed);
+        return 1;
+    }
+
+    printf("failsafe_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test/replay_test.cpp
+ * @brief BusRecorder で記録し ReplayTransport で再生するホスト用テスト
+ *
+ *  -# LoopbackTransport でモジュールの応答を与えながら制御を動かし，通信を記録する
+ *  -# 記録を ReplayTransport で再生し，同じ制御なら送信がすべて一致することを確認する
+ *  -# 制御を変えると，変わった送信フレームの番号が得られることを確認する
+ */
+
+#include <Arduino.h>
+
+#include "../ReplayTransport.h"
+
+
+static unsigned long failed = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ if(failed++ < 20) printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); } }while(0)
+
+#define CYCLE 10000     // 制御周期[us]
+#define CYCLE_NUM 12
+
+
+/*
+ * 書き出し先のメモリ
+ */
+class MemoryPrint : public Print
+{
+public:
+    MemoryPrint(){ len = 0; }
+    size_t write(uint8_t data){ if(len < (int)sizeof(buff)) buff[len++] = data; return 1; }
+    using Print::write;
+
+    uint8_t buff[RECORDER_SIZE];
+    int len;
+};
+
+
+/*
+ * 記録と再生で同じように動かす制御
+ */
+static void control(Fets &fet, UnderBody &body, int offset){
+    int in = fet.getInputState(Fets::In1);
+    const UnderBody::odometry &odom = body.getOdometry();
+
+    if(in == 1){
+        body.stop();
+    }
+    else{
+        body.moveXY(odom.vX + offset, 0, 0);
+    }
+    fet.write(in, Fets::Out1);
+}
+
+/*
+ * 制御を変えて再生する
+ *
+ * @return  最初に変わった送信フレームの番号
+ */
+static long replay(const uint8_t *log, int len, int offset, unsigned long *mismatched){
+    ReplayTransport Replay(log, len);
+    T_Fets Fet(&Replay);
+    T_UnderBody Body(&Replay);
+
+    for(int k=0; k<CYCLE_NUM; k++){
+        Replay.setTime((unsigned long)k * CYCLE);
+        control(Fet, Body, offset);
+    }
+
+    CHECK(Replay.getRemaining() == 0);
+    CHECK(Replay.getExtra() == 0);
+    CHECK(Replay.getMatched() + Replay.getMismatched() == 2 * CYCLE_NUM);
+
+    *mismatched = Replay.getMismatched();
+    return Replay.getFirstMismatch();
+}
+
+
+int main(){
+    LoopbackTransport Master, Module;
+    T_Fets Fet(&Master);
+    T_UnderBody Body(&Master);
+    BusRecorder Recorder;
+    MemoryPrint Log;
+    unsigned long mismatched;
+
+    Master.connect(&Module);
+    Master.attachRecorder(&Recorder);      // 受信は通信路で1回だけ記録する
+    Fet.attachRecorder(&Recorder);
+    Body.attachRecorder(&Recorder);
+
+    hostMicros = 5000000;
+
+    for(int k=0; k<CYCLE_NUM; k++){
+        uint8_t frame[8];
+
+        hostMicros = 5000000 + (unsigned long)k * CYCLE;
+
+        if(k == 0 || k == 6 || k == 9){     // モジュールからの状態通知
+            uint8_t in = (k == 6) ? 0x01 : 0x00;
+            frame[0] = in;                  // 入力 , 出力 , xor , ID
+            frame[1] = 0x00;
+            frame[2] = frame[0] ^ frame[1];
+            frame[3] = DEF_ID;
+            Module.sendFrame(frame, 4);
+        }
+        if(k % 3 == 1){                     // 足回りからの速度
+            UnderBody::makeFrame(frame, 10 * k, 0, 0, ODOM_VELO);
+            Module.sendFrame(frame, 8);
+        }
+
+        control(Fet, Body, 100);
+
+        while(Module.readByte() != -1);     // 送信されたフレームは捨てる
+    }
+
+    CHECK(Recorder.getDropped() == 0);
+    CHECK(Recorder.dump(&Log) == Log.len);
+    CHECK(Body.getOdometry().vX == 100);
+
+    CHECK(replay(Log.buff, Log.len, 100, &mismatched) == -1);      // 同じ制御
+    CHECK(mismatched == 0);
+
+    CHECK(replay(Log.buff, Log.len, 101, &mismatched) == 0);       // 足回りへの最初の送信から変わる
+    CHECK(mismatched == CYCLE_NUM - 3);     // 入力が1の3周期は stop() で同じ
+
+    if(failed){
+        printf("replay_test: %lu checks failed\n", failed);
+        return 1;
+    }
+
+    printf("replay_test: ok\n");
+    return 0;
+}